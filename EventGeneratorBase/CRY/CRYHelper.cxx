@@ -176,20 +176,19 @@ namespace evgb{
 	int imother1   = kCosmicRayGenerator;
 	
 	// Push the particle onto the stack
-	std::string primary("primary");
+	static const std::string primary("primary");
 	
 	particlespushed=true;
-	simb::MCParticle p(idctr,
-			   pdg,
-			   primary,
-			   imother1,
-			   m,
-			   istatus);
+	simb::MCParticle& p = mctruth.Emplace(idctr,
+					      pdg,
+					      primary,
+					      imother1,
+					      m,
+					      istatus);
 	TLorentzVector pos(vx,vy,vz,t*1e9);// time needs to be in ns to match GENIE, etc
 	TLorentzVector mom(px,py,pz,etot);
 	p.AddTrajectoryPoint(pos,mom);
 	
-	mctruth.Add(p);
 	++idctr;
       } // Loop on particles in event
 
@@ -1497,14 +1497,16 @@ namespace evgb {
     int trackid = 0;
     std::string primary("primary");
 
+    truth.Reserve(truth.NParticles() + record->GetEntries());
+
     while( (part = dynamic_cast<genie::GHepParticle *>(partitr.Next())) ){
     
-      simb::MCParticle tpart(trackid, 
-			     part->Pdg(), 
-			     primary, 
-			     part->FirstMother(), 
-			     part->Mass(), 
-			     part->Status());
+      simb::MCParticle& tpart = truth.Emplace(trackid, 
+					      part->Pdg(), 
+					      primary, 
+					      part->FirstMother(), 
+					      part->Mass(), 
+					      part->Status());
       double vtx[4] = {part->Vx(), part->Vy(), part->Vz(), part->Vt()};
       tpart.SetGvtx(vtx);
       tpart.SetRescatter(part->RescatterCode());
@@ -1525,7 +1527,6 @@ namespace evgb {
 	part->GetPolarization(polz);
 	tpart.SetPolarization(polz);
       }
-      truth.Add(tpart);
 
       ++trackid;        
     }// end loop to convert GHepParticles to MCParticles
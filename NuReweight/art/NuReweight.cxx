@@ -116,36 +116,19 @@ namespace rwgt {
     newEvent.SetVertex(vtx);
 
     for(int i = 0; i < truth.NParticles(); i++) {
-      simb::MCParticle mcpart = truth.GetParticle(i);
+      const simb::MCParticle& mcpart = truth.GetParticle(i);
       
       int gmid = mcpart.PdgCode();
       genie::GHepStatus_t gmst = (genie::GHepStatus_t)mcpart.StatusCode();
       int gmmo = mcpart.Mother();
       int ndaughters = mcpart.NumberDaughters();
-      //find the track ID of the first and last daughter particles
-      int fdtrkid = 0;
-      int ldtrkid = 0;
-      if(ndaughters !=0) {
-	fdtrkid = mcpart.Daughter(0);
-	if(ndaughters == 1) {
-	  ldtrkid = 1;
-	}
-	else if(ndaughters >1) {
-	  fdtrkid = mcpart.Daughter(ndaughters-1);
-	}
-      }      
-      int gmfd = -1;
-      int gmld = -1;
       //Genie uses the index in the particle array to reference the daughter particles.
       //MCTruth keeps the particles in the same order so use the track ID to find the proper index.
-      for(int j = 0; j < truth.NParticles(); j++) {
-	simb::MCParticle temp = truth.GetParticle(i);
-	if(temp.TrackId() == fdtrkid) {
-	  gmfd = j;
-	}
-	if(temp.TrackId() == ldtrkid) {
-	  gmld = j;
-	}
+      int gmfd = -1;
+      int gmld = -1;
+      if(ndaughters !=0) {
+	gmfd = truth.FindByTrackId(mcpart.FirstDaughter());
+	gmld = truth.FindByTrackId(mcpart.LastDaughter());
       }
     
       double gmpx = mcpart.Px(0);
@@ -222,6 +222,17 @@ namespace simb{
   
   //......................................................................
   void MCFlux::ReDecay(double &newE, double &newW, double x, double y, double z)
+  {
+    this->ReDecay(1, &x, &y, &z, &newE, &newW);
+  }
+
+  //......................................................................
+  void MCFlux::ReDecay(size_t        n,
+		       const double* x,
+		       const double* y,
+		       const double* z,
+		       double*       newE,
+		       double*       newW) const
   {
     //note x,y,z are assumed to be in cm
     //x,y,z are also assumed to be in the beam reference frame
@@ -255,126 +266,118 @@ namespace simb{
       return;
     }
 
+    //everything from here to the loop over points depends only on the
+    //parent, so it is done once for the whole batch
+
     //compute kinematics of parent particle at decay point
-    double p=sqrt(1.*fpdpx*fpdpx+1.*fpdpy*fpdpy+1.*fpdpz*fpdpz);
-    double Eplab=sqrt(1.*fpdpx*fpdpx+1.*fpdpy*fpdpy+1.*fpdpz*fpdpz+1.*mass*mass);
-    double gamma = Eplab/mass;
-    double beta = sqrt((gamma*gamma-1)/(gamma*gamma));
-  
-    //compute components of vector between decay point 
-    //and the point you're aiming at
-    double rnx=1.*(x-fvx);
-    double rny=1.*(y-fvy);
-    double rnz=1.*(z-fvz);
-    double rn=sqrt(rnx*rnx+rny*rny+rnz*rnz);
-  
-    //compute angle between parent momentum 
-    //and where we want the neutrino to go
-    double rndotp = (rnx*fpdpx+rny*fpdpy+rnz*fpdpz);
-    double costhetan = rndotp/(rn*p);
-  
-    //do some checking of the calculation
-    if(std::abs(costhetan)>1){
-      if(costhetan>0){
-	costhetan = 1;
-      }
-      else{
-	costhetan=-1;
-      }
-    }
+    const double p=sqrt(1.*fpdpx*fpdpx+1.*fpdpy*fpdpy+1.*fpdpz*fpdpz);
+    const double Eplab=sqrt(1.*fpdpx*fpdpx+1.*fpdpy*fpdpy+1.*fpdpz*fpdpz+1.*mass*mass);
+    const double gamma = Eplab/mass;
+    const double beta = sqrt((gamma*gamma-1)/(gamma*gamma));
+    const bool   boost = (p>0); //if it didn't decay at rest
 
-    //now compute the weights
-    double MN=1.;
-    if(p>0){//if it didn't decay at rest
-      //boost 
-      MN=1./(gamma*(1-beta*costhetan));
-    }
+    //if its a (polarized) muon decay, we have modify the weight
+    const bool polarized = (fptype==13||fptype==-13);
+    double betav[3]={0.};
+    double P_pcm_mp[4]={0.};
+    double xnu = 0.;
+    const bool numu = (fntype==14||fntype==-14);
+    if(polarized){
+      betav[0] = fpdpx/Eplab;
+      betav[1] = fpdpy/Eplab;
+      betav[2] = fpdpz/Eplab;
 
+      //the muon's parent, in the muon's rest frame
+      const double gammap = fppenergy/mass;  
+      double betap[3]={0.};
+      betap[0] = fppdxdz*fpppz/fppenergy;
+      betap[1] = fppdydz*fpppz/fppenergy;
+      betap[2] = fpppz/fppenergy;
+    
+      double partial = gammap*(betap[0]*fmuparpx +
+			       +betap[1]*fmuparpy + betap[2]*fmuparpz);
+      partial = fmupare-partial/(gammap+1.);
+      P_pcm_mp[0] = fmuparpx - betap[0]*gammap*partial;
+      P_pcm_mp[1] = fmuparpy - betap[1]*gammap*partial;
+      P_pcm_mp[2] = fmuparpz - betap[2]*gammap*partial;
+      P_pcm_mp[3] = sqrt(pow(P_pcm_mp[0],2)+
+			 pow(P_pcm_mp[1],2)+
+			 pow(P_pcm_mp[2],2));
 
-    newE = MN*fnecm;
-    //  std::cout<<"New E "<<newE<<" old ecm "<<fnecm<<" mn "<<MN<<" gamma "<<gamma<<" beta "<<beta<<" costhetan "<<costhetan<<std::endl;
+      xnu = 2.*fnecm/mass;
+    }
 
     //solid angle
     // small angle approximation: // double san = 10000./(4*rn*rn);
     // Alex Radovic's removal of small angle approximation
     const double kRDET = 100.; 
-    double san = (1.0-cos(atan( kRDET / rn )))/2.0;
 
-    //  std::cout<<"san "<<san<<" fvz-z "<<fvz-z<<std::endl;
-    newW = san*MN*MN;
-    //  std::cout<<"mn "<<MN<<std::endl;
-
-
-    //if its a (polarized) muon decay, we have modify the weight
-    if(fptype==13||fptype==-13){
-      double betav[3]={0.};
-      double partialn=0.;
-      double partial=0.;
-      double P_nun[3]={0.};
-      double P_dcm_nun[4]={0.};
-      double P_pcm_mp[4]={0.};
-
-      betav[0] = fpdpx/Eplab;
-      betav[1] = fpdpy/Eplab;
-      betav[2] = fpdpz/Eplab;
+    for(size_t i = 0; i < n; ++i){
+      //compute components of vector between decay point 
+      //and the point you're aiming at
+      const double rnx=1.*(x[i]-fvx);
+      const double rny=1.*(y[i]-fvy);
+      const double rnz=1.*(z[i]-fvz);
+      const double rn=sqrt(rnx*rnx+rny*rny+rnz*rnz);
   
-      P_nun[0] = rnx*newE/rn;
-      P_nun[1] = rny*newE/rn;
-      P_nun[2] = rnz*newE/rn;
+      //compute angle between parent momentum 
+      //and where we want the neutrino to go
+      const double rndotp = (rnx*fpdpx+rny*fpdpy+rnz*fpdpz);
+      double costhetan = rndotp/(rn*p);
   
-      partialn =gamma*(betav[0]*P_nun[0]+betav[1]*P_nun[1]+betav[2]*P_nun[2]);
-      partialn = newE - partialn /(gamma+1.);
-    
-      P_dcm_nun[0] = P_nun[0] - betav[0]*gamma*partialn;
-      P_dcm_nun[1] = P_nun[1] - betav[1]*gamma*partialn;
-      P_dcm_nun[2] = P_nun[2] - betav[2]*gamma*partialn;
-      P_dcm_nun[3] = sqrt(pow(P_dcm_nun[0],2)
-			  +pow(P_dcm_nun[1],2)
-			  +pow(P_dcm_nun[2],2));
-    
+      //do some checking of the calculation
+      if(std::abs(costhetan)>1){
+	costhetan = (costhetan>0) ? 1 : -1;
+      }
 
-      gamma = fppenergy/mass;  
-      betav[0] = fppdxdz*fpppz/fppenergy;
-      betav[1] = fppdydz*fpppz/fppenergy;
-      betav[2] = fpppz/fppenergy;
+      //now compute the weights
+      const double MN = boost ? 1./(gamma*(1-beta*costhetan)) : 1.;
+      const double E  = MN*fnecm;
+      const double san = (1.0-cos(atan( kRDET / rn )))/2.0;
+      double W = san*MN*MN;
 
-      partial = gamma*(betav[0]*fmuparpx +
-		       +betav[1]*fmuparpy + betav[2]*fmuparpz);
-      partial = fmupare-partial/(gamma+1.);
-      P_pcm_mp[0] = fmuparpx - betav[0]*gamma*partial;
-      P_pcm_mp[1] = fmuparpy - betav[1]*gamma*partial;
-      P_pcm_mp[2] = fmuparpz - betav[2]*gamma*partial;
-      P_pcm_mp[3] = sqrt(pow(P_pcm_mp[0],2)+
-			 pow(P_pcm_mp[1],2)+
-			 pow(P_pcm_mp[2],2));
+      if(polarized){
+	double P_nun[3]={0.};
+	double P_dcm_nun[4]={0.};
+	P_nun[0] = rnx*E/rn;
+	P_nun[1] = rny*E/rn;
+	P_nun[2] = rnz*E/rn;
   
-      //calc new  decay angle w.r.t. (anti)spin direction
-      double costhn  = 0.;
-      if(P_dcm_nun[3]!=0&&P_pcm_mp[3]!=0){
-	costhn = ( P_dcm_nun[0]*P_pcm_mp[0]+
-		   P_dcm_nun[1]*P_pcm_mp[1]+
-		   P_dcm_nun[2]*P_pcm_mp[2])/(P_dcm_nun[3]*P_pcm_mp[3]);
-      }
+	double partialn =gamma*(betav[0]*P_nun[0]+betav[1]*P_nun[1]+betav[2]*P_nun[2]);
+	partialn = E - partialn /(gamma+1.);
     
-      if(std::abs(costhn)>1){
-	if(costhn>0){
-	  costhn = 1;
+	P_dcm_nun[0] = P_nun[0] - betav[0]*gamma*partialn;
+	P_dcm_nun[1] = P_nun[1] - betav[1]*gamma*partialn;
+	P_dcm_nun[2] = P_nun[2] - betav[2]*gamma*partialn;
+	P_dcm_nun[3] = sqrt(pow(P_dcm_nun[0],2)
+			    +pow(P_dcm_nun[1],2)
+			    +pow(P_dcm_nun[2],2));
+    
+	//calc new  decay angle w.r.t. (anti)spin direction
+	double costhn  = 0.;
+	if(P_dcm_nun[3]!=0&&P_pcm_mp[3]!=0){
+	  costhn = ( P_dcm_nun[0]*P_pcm_mp[0]+
+		     P_dcm_nun[1]*P_pcm_mp[1]+
+		     P_dcm_nun[2]*P_pcm_mp[2])/(P_dcm_nun[3]*P_pcm_mp[3]);
 	}
-	else{
-	  costhn=-1;
+    
+	if(std::abs(costhn)>1){
+	  costhn = (costhn>0) ? 1 : -1;
 	}
-      }
     
-      double wt_ration;
-      if(fntype==14||fntype==-14){
-	double xnu = 2.*fnecm/mass;
-	wt_ration = ( (3.-2.*xnu) - (1.-2.*xnu)*costhn ) / (3.-2.*xnu);
-      }
-      else{
-	wt_ration=1.-costhn;
-      }
+	double wt_ration;
+	if(numu){
+	  wt_ration = ( (3.-2.*xnu) - (1.-2.*xnu)*costhn ) / (3.-2.*xnu);
+	}
+	else{
+	  wt_ration=1.-costhn;
+	}
   
-      newW*=wt_ration;
+	W*=wt_ration;
+      }
+
+      newE[i] = E;
+      newW[i] = W;
     }
 
     return;
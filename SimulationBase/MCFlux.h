@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <vector>
+#include <cstddef>
 
 namespace simb{
 
@@ -131,6 +132,16 @@ namespace simb{
 		 double y, 
 		 double z);
 
+    /// ReDecay for n points at once, giving the same results as n calls
+    /// of the single point version.  The parent kinematics are worked
+    /// out once for all the points.
+    void ReDecay(size_t        n,
+		 const double* x,
+		 const double* y,
+		 const double* z,
+		 double*       newE,
+		 double*       newW) const;
+
     friend std::ostream& operator<< (std::ostream& output, const simb::MCFlux &mcflux);
     
 #endif
@@ -34,8 +34,8 @@ namespace simb {
     , ftrackId(s_uninitialized)
     , fpdgCode(s_uninitialized)
     , fmother(s_uninitialized)
-    , fprocess()
-    , fendprocess()
+    , fprocessCode(ProcessNameTable::Instance().Code(std::string()))
+    , fendprocessCode(ProcessNameTable::Instance().Code(std::string()))
     , fmass(s_uninitialized)
     , fpolarization()
     , fdaughters()
@@ -49,7 +49,7 @@ namespace simb {
   /// Standard constructor.
   MCParticle::MCParticle(const int trackId, 
 			 const int pdg, 
-			 const std::string process,
+			 const std::string& process,
 			 const int mother, 
 			 const double mass,
 			 const int status)
@@ -57,8 +57,8 @@ namespace simb {
     , ftrackId(trackId)
     , fpdgCode(pdg)
     , fmother(mother)
-    , fprocess(process)
-    , fendprocess(std::string())
+    , fprocessCode(ProcessNameTable::Instance().Code(process))
+    , fendprocessCode(ProcessNameTable::Instance().Code(std::string()))
     , fmass(mass)
     , fpolarization()
     , fdaughters()
@@ -88,16 +88,18 @@ namespace simb {
     , ftrackId(p.TrackId()+offset)
     , fpdgCode(p.PdgCode())
     , fmother(p.Mother()+offset)
-    , fprocess(p.Process())
-    , fendprocess(p.EndProcess())
+    , fprocessCode(p.ProcessCode())
+    , fendprocessCode(p.EndProcessCode())
     , ftrajectory(p.Trajectory())
     , fmass(p.Mass())
     , fWeight(p.Weight())
     , fGvtx(p.GetGvtx())
     , frescatter(p.Rescatter())
   {
-    for(int i=0; i<p.NumberDaughters(); i++)
-      fdaughters.insert(p.Daughter(i)+offset);
+    // shifting every ID by the same amount keeps them sorted
+    fdaughters.reserve(p.fdaughters.size());
+    for(daughters_type::const_iterator i = p.fdaughters.begin(); i != p.fdaughters.end(); ++i)
+      fdaughters.push_back(*i + offset);
   }
   //------------------------------------------------------------
   MCParticle::~MCParticle() 
@@ -106,18 +108,9 @@ namespace simb {
 
 
   //----------------------------------------------------------------------------
-  void MCParticle::SetEndProcess(std::string s)
+  void MCParticle::SetEndProcess(std::string const& s)
   {
-    fendprocess = s;
-  }
-
-  //------------------------------------------------------------
-  // Return the "index-th' daughter in the list.
-  int MCParticle::Daughter( const int index ) const
-  {
-    daughters_type::const_iterator i = fdaughters.begin();
-    std::advance( i, index );
-    return *i;
+    fendprocessCode = ProcessNameTable::Instance().Code(s);
   }
 
   //----------------------------------------------------------------------------
@@ -12,10 +12,12 @@
 #define SIMB_MCPARTICLE_H
 
 #include "SimulationBase/MCTrajectory.h"
+#include "SimulationBase/ProcessNameTable.h"
 
-#include <set>
+#include <vector>
 #include <string>
 #include <iostream>
+#include <algorithm>
 #include "TVector3.h"
 #include "TLorentzVector.h"
 
@@ -33,18 +35,18 @@ namespace simb {
     virtual ~MCParticle();
 
   protected:
-    typedef std::set<int>   daughters_type;
+    typedef std::vector<int> daughters_type;
 
     int                     fstatus;        ///< Status code from generator, geant, etc
     int                     ftrackId;       ///< TrackId
     int                     fpdgCode;       ///< PDG code
     int                     fmother;        ///< Mother
-    std::string             fprocess;       ///< Detector-simulation physics process that created the particle
-    std::string             fendprocess;    ///< end process for the particle
+    unsigned short          fprocessCode;   ///< Detector-simulation physics process that created the particle, as a simb::ProcessNameTable code
+    unsigned short          fendprocessCode;///< end process for the particle, as a simb::ProcessNameTable code
     simb::MCTrajectory      ftrajectory;    ///< particle trajectory (position,momentum)
     double                  fmass;          ///< Mass; from PDG unless overridden Should be in GeV
     TVector3                fpolarization;  ///< Polarization
-    daughters_type          fdaughters;     ///< Sorted list of daughters of this particle.
+    daughters_type          fdaughters;     ///< Sorted list of daughters of this particle, without duplicates.
     double                  fWeight;        ///< Assigned weight to this particle for MC tests
     TLorentzVector          fGvtx;          ///< Vertex needed by generater (genie) to rebuild 
                                             ///< genie::EventRecord for event reweighting
@@ -59,7 +61,7 @@ namespace simb {
     // mother = -1 means that this particle has no mother
     MCParticle(const int trackId, 
 	       const int pdg, 
-	       const std::string process,
+	       const std::string& process,
 	       const int mother  = -1, 
 	       const double mass = s_uninitialized,
 	       const int status  = 1);
@@ -68,6 +70,8 @@ namespace simb {
     // our own copy and assignment constructors.
     MCParticle(MCParticle const &)            = default; // Copy constructor.
     MCParticle& operator=( const MCParticle&) = default;
+    MCParticle(MCParticle&&)                  = default; // Move constructor.
+    MCParticle& operator=( MCParticle&&)      = default;
 
     //constructor for copy from MCParticle, buth with offset trackID
     MCParticle(MCParticle const&, int);
@@ -98,17 +102,23 @@ namespace simb {
 
     // The detector-simulation physics process that created the
     // particle. If this is a primary particle, it will have the
-    // value "primary"
-    std::string Process()   const;
+    // value "primary".  The names live in simb::ProcessNameTable,
+    // so these return references rather than copies, and the codes
+    // are available for cheap comparisons.
+    const std::string& Process()        const;
+    unsigned short     ProcessCode()    const;
 
-    std::string EndProcess()   const;
-    void SetEndProcess(std::string s);
+    const std::string& EndProcess()     const;
+    unsigned short     EndProcessCode() const;
+    void SetEndProcess(std::string const& s);
 
     // Accessors for daughter information.  Note that it's possible
     // (even likely) for a daughter track not to be included in a
     // Particle list, if that daughter particle falls below the energy
     // cut.
     void AddDaughter( const int trackID );
+    template <class InputIt>
+    void AddDaughters( InputIt first, InputIt last ); //> Add many daughters, sorting only once.
     int  NumberDaughters()               const;
     int  Daughter(const int i)           const; //> Returns the track ID for the "i-th" daughter.
 
@@ -118,19 +128,19 @@ namespace simb {
     // To avoid confusion with the X() and Y() methods of MCTruth
     // (which return Feynmann x and y), use "Vx,Vy,Vz" for the
     // vertex.
-    const TLorentzVector& Position( const int i = 0 ) const;
+    TLorentzVector        Position( const int i = 0 ) const;
     double                Vx(const int i = 0)         const;
     double 		  Vy(const int i = 0) 	      const;
     double 		  Vz(const int i = 0) 	      const;
     double 		   T(const int i = 0) 	      const;
 				                                                     
-    const TLorentzVector& EndPosition() const;
+    TLorentzVector        EndPosition() const;
     double                EndX()        const;
     double          	  EndY()        const;
     double          	  EndZ()        const;
     double          	  EndT()        const;
 
-    const TLorentzVector& Momentum( const int i = 0 ) const;
+    TLorentzVector        Momentum( const int i = 0 ) const;
     double                Px(const int i = 0)         const;
     double          	  Py(const int i = 0) 	      const;
     double          	  Pz(const int i = 0) 	      const;
@@ -139,7 +149,7 @@ namespace simb {
     double          	  Pt(const int i = 0) 	      const;
     double          	  Mass()                      const;
 
-    const TLorentzVector& EndMomentum() const;
+    TLorentzVector        EndMomentum() const;
     double                EndPx()       const;
     double          	  EndPy()       const;
     double          	  EndPz()       const;
@@ -181,6 +191,19 @@ namespace simb {
     void AddTrajectoryPoint( const TLorentzVector& position, 
 			     const TLorentzVector& momentum );
 
+    // As above, but sparsify the trajectory as it is built instead of
+    // afterwards, so the full list of points is never held in memory.
+    // The previous point is dropped if it lies within margin of the
+    // straight line between the points kept on either side, just as
+    // SparsifyTrajectory would do.  At most window points are dropped
+    // in a row.  The margin belongs to whoever builds the particles
+    // (e.g. a configuration parameter of the simulation), which passes
+    // it with every point; a margin of 0 keeps every point.
+    void AddTrajectoryPoint( const TLorentzVector& position, 
+			     const TLorentzVector& momentum,
+			     double                sparsifyMargin,
+			     unsigned int          sparsifyWindow = 100 );
+
     // methods for giving/accessing a weight to this particle for use
     // in studies of rare processes, etc
     double Weight() const;
@@ -188,6 +211,10 @@ namespace simb {
 
     void SparsifyTrajectory();
 
+    // Encode the trajectory compactly for writing (see MCTrajectoryCodec);
+    // it has no points until it is unpacked again.
+    void PackTrajectory(simb::MCTrajectoryCodec const& codec);
+
     // Define a comparison operator for particles.  This allows us to
     // keep them in sets or maps.  It makes sense to order a list of
     // particles by track ID... but take care!  After we get past the
@@ -214,45 +241,48 @@ inline 	     int             simb::MCParticle::StatusCode()    	    	const { ret
 inline 	     int             simb::MCParticle::PdgCode()       	    	const { return fpdgCode;           		   }
 inline 	     int             simb::MCParticle::Mother()        	    	const { return fmother;            		   }
 inline const TVector3&       simb::MCParticle::Polarization()  	    	const { return fpolarization;      		   }
-inline       std::string     simb::MCParticle::Process()       	    	const { return fprocess;           		   }
-inline       std::string     simb::MCParticle::EndProcess()       	const { return fendprocess;           		   }
+inline const std::string&    simb::MCParticle::Process()       	    	const { return simb::ProcessNameTable::Instance().Name(fprocessCode);    }
+inline       unsigned short  simb::MCParticle::ProcessCode()   	    	const { return fprocessCode;                       }
+inline const std::string&    simb::MCParticle::EndProcess()       	const { return simb::ProcessNameTable::Instance().Name(fendprocessCode); }
+inline       unsigned short  simb::MCParticle::EndProcessCode()       	const { return fendprocessCode;                    }
 inline       int             simb::MCParticle::NumberDaughters() 	const { return fdaughters.size();  		   }
+inline       int             simb::MCParticle::Daughter(const int i)    const { return fdaughters[i];                      }
 inline       unsigned int    simb::MCParticle::NumberTrajectoryPoints() const { return ftrajectory.size(); 		   }
-inline const TLorentzVector& simb::MCParticle::Position( const int i )  const { return ftrajectory.Position(i);            }
-inline const TLorentzVector& simb::MCParticle::Momentum( const int i )  const { return ftrajectory.Momentum(i);            }
-inline       double          simb::MCParticle::Vx(const int i)          const { return Position(i).X();    		   }
-inline       double          simb::MCParticle::Vy(const int i)          const { return Position(i).Y();    		   }
-inline       double          simb::MCParticle::Vz(const int i)          const { return Position(i).Z();    		   }
-inline       double          simb::MCParticle::T(const int i)           const { return Position(i).T();    		   }
-inline const TLorentzVector& simb::MCParticle::EndPosition()            const { return Position(ftrajectory.size()-1);     }
-inline       double          simb::MCParticle::EndX()                   const { return Position(ftrajectory.size()-1).X(); }
-inline       double          simb::MCParticle::EndY()                   const { return Position(ftrajectory.size()-1).Y(); }
-inline       double          simb::MCParticle::EndZ()                   const { return Position(ftrajectory.size()-1).Z(); }
-inline       double          simb::MCParticle::EndT()                   const { return Position(ftrajectory.size()-1).T(); }
-inline       double          simb::MCParticle::Px(const int i)          const { return Momentum(i).Px();                   }
-inline       double          simb::MCParticle::Py(const int i)          const { return Momentum(i).Py();    	           }
-inline       double          simb::MCParticle::Pz(const int i)          const { return Momentum(i).Pz();    	           }
-inline       double          simb::MCParticle::E(const int i)           const { return Momentum(i).E();     	           }
-inline       double          simb::MCParticle::P(const int i)           const { return std::sqrt(std::pow(Momentum(i).E(),
+inline       TLorentzVector  simb::MCParticle::Position( const int i )  const { return ftrajectory.Position(i);            }
+inline       TLorentzVector  simb::MCParticle::Momentum( const int i )  const { return ftrajectory.Momentum(i);            }
+inline       double          simb::MCParticle::Vx(const int i)          const { return ftrajectory.X(i);                   }
+inline       double          simb::MCParticle::Vy(const int i)          const { return ftrajectory.Y(i);                   }
+inline       double          simb::MCParticle::Vz(const int i)          const { return ftrajectory.Z(i);                   }
+inline       double          simb::MCParticle::T(const int i)           const { return ftrajectory.T(i);                   }
+inline       TLorentzVector  simb::MCParticle::EndPosition()            const { return Position(ftrajectory.size()-1);     }
+inline       double          simb::MCParticle::EndX()                   const { return ftrajectory.X(ftrajectory.size()-1);  }
+inline       double          simb::MCParticle::EndY()                   const { return ftrajectory.Y(ftrajectory.size()-1);  }
+inline       double          simb::MCParticle::EndZ()                   const { return ftrajectory.Z(ftrajectory.size()-1);  }
+inline       double          simb::MCParticle::EndT()                   const { return ftrajectory.T(ftrajectory.size()-1);  }
+inline       double          simb::MCParticle::Px(const int i)          const { return ftrajectory.Px(i);                  }
+inline       double          simb::MCParticle::Py(const int i)          const { return ftrajectory.Py(i);                  }
+inline       double          simb::MCParticle::Pz(const int i)          const { return ftrajectory.Pz(i);                  }
+inline       double          simb::MCParticle::E(const int i)           const { return ftrajectory.E(i);                   }
+inline       double          simb::MCParticle::P(const int i)           const { return std::sqrt(std::pow(ftrajectory.E(i),
        											      2.)  
        										     - std::pow(fmass,2.));                }
-inline       double          simb::MCParticle::Pt(const int i)          const { return std::sqrt(std::pow(Momentum(i).Px(),
+inline       double          simb::MCParticle::Pt(const int i)          const { return std::sqrt(std::pow(ftrajectory.Px(i),
        											      2.) 
-       										     + std::pow(Momentum(i).Py(),
+       										     + std::pow(ftrajectory.Py(i),
        												2.));                      }
 inline       double          simb::MCParticle::Mass()                   const { return fmass;                              }
-inline const TLorentzVector& simb::MCParticle::EndMomentum()            const { return Momentum(ftrajectory.size()-1);     }
-inline       double          simb::MCParticle::EndPx()                  const { return Momentum(ftrajectory.size()-1).X(); }
-inline       double          simb::MCParticle::EndPy()                  const { return Momentum(ftrajectory.size()-1).Y(); }
-inline       double          simb::MCParticle::EndPz()                  const { return Momentum(ftrajectory.size()-1).Z(); }
-inline       double          simb::MCParticle::EndE()                   const { return Momentum(ftrajectory.size()-1).T(); }
+inline       TLorentzVector  simb::MCParticle::EndMomentum()            const { return Momentum(ftrajectory.size()-1);     }
+inline       double          simb::MCParticle::EndPx()                  const { return ftrajectory.Px(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndPy()                  const { return ftrajectory.Py(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndPz()                  const { return ftrajectory.Pz(ftrajectory.size()-1); }
+inline       double          simb::MCParticle::EndE()                   const { return ftrajectory.E(ftrajectory.size()-1);  }
 inline       TLorentzVector  simb::MCParticle::GetGvtx()                const { return fGvtx;                              }
 inline       double          simb::MCParticle::Gvx()                    const { return fGvtx.X();                          }
 inline       double          simb::MCParticle::Gvy()                    const { return fGvtx.Y();                          }
 inline       double          simb::MCParticle::Gvz()                    const { return fGvtx.Z();                          }
 inline       double          simb::MCParticle::Gvt()                    const { return fGvtx.T();                          }
-inline       int             simb::MCParticle::FirstDaughter()          const { return *(fdaughters.begin());              }
-inline       int             simb::MCParticle::LastDaughter()           const { return *(fdaughters.rbegin());             }
+inline       int             simb::MCParticle::FirstDaughter()          const { return fdaughters.front();                 }
+inline       int             simb::MCParticle::LastDaughter()           const { return fdaughters.back();                  }
 inline       int             simb::MCParticle::Rescatter()              const { return frescatter;                         }
 inline const simb::MCTrajectory& simb::MCParticle::Trajectory()         const { return ftrajectory;                        }
 inline       double          simb::MCParticle::Weight()                 const { return fWeight;                            }
@@ -261,8 +291,37 @@ inline       double          simb::MCParticle::Weight()                 const {
 inline       void            simb::MCParticle::AddTrajectoryPoint(const TLorentzVector& position, 
 								  const TLorentzVector& momentum )
                                                                                   { ftrajectory.Add( position, momentum ); }
+inline       void            simb::MCParticle::AddTrajectoryPoint(const TLorentzVector& position, 
+								  const TLorentzVector& momentum,
+								  double                sparsifyMargin,
+								  unsigned int          sparsifyWindow )
+{ 
+  if(sparsifyMargin > 0.) ftrajectory.AddSparsified( position, momentum, sparsifyMargin, sparsifyWindow );
+  else                    ftrajectory.Add( position, momentum );
+}
 inline       void            simb::MCParticle::SparsifyTrajectory()               { ftrajectory.Sparsify();                }
-inline       void            simb::MCParticle::AddDaughter(const int trackID)     { fdaughters.insert(trackID); 	   }
+inline       void            simb::MCParticle::PackTrajectory(simb::MCTrajectoryCodec const& codec) { ftrajectory.Pack(codec); }
+
+// daughters usually arrive in increasing track ID order, so this is
+// normally just an append
+inline       void            simb::MCParticle::AddDaughter(const int trackID)
+{
+  if(fdaughters.empty() || fdaughters.back() < trackID){
+    fdaughters.push_back(trackID);
+    return;
+  }
+  daughters_type::iterator i = std::lower_bound(fdaughters.begin(), fdaughters.end(), trackID);
+  if(*i != trackID) fdaughters.insert(i, trackID);
+}
+
+template <class InputIt>
+inline       void            simb::MCParticle::AddDaughters(InputIt first, InputIt last)
+{
+  fdaughters.insert(fdaughters.end(), first, last);
+  std::sort(fdaughters.begin(), fdaughters.end());
+  fdaughters.erase(std::unique(fdaughters.begin(), fdaughters.end()), fdaughters.end());
+}
+
 inline       void            simb::MCParticle::SetPolarization(TVector3 const& p) { fpolarization = p;          	   }
 inline       void            simb::MCParticle::SetRescatter(int code)             { frescatter    = code;       	   }
 inline       void            simb::MCParticle::SetWeight(double wt)               { fWeight       = wt;         	   }
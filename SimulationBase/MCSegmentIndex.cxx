@@ -0,0 +1,509 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCSegmentIndex.cxx
+/// \brief Spatial lookup of the trajectory segments of an event's particles
+////////////////////////////////////////////////////////////////////////
+#include "SimulationBase/MCSegmentIndex.h"
+#include "SimulationBase/MCParticle.h"
+#include "SimulationBase/MCTrajectory.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+  // keeps the grid, and the memory it takes, bounded however the
+  // segments are spread out
+  const int kMaxCellsPerAxis = 256;
+
+  // order hits by distance, then by track and segment so that ties come
+  // out the same way every time
+  bool HitLess(simb::MCSegmentHit const& a, simb::MCSegmentHit const& b)
+  {
+    if(a.fDistance != b.fDistance) return a.fDistance < b.fDistance;
+    if(a.fTrackId  != b.fTrackId ) return a.fTrackId  < b.fTrackId;
+    return a.fSegment < b.fSegment;
+  }
+
+  // Clip the segment p0-p1 to the box lo-hi.  Returns false if it misses
+  // the box, otherwise the part inside is between parameters t0 and t1.
+  bool ClipToBox(const double* p0, const double* p1,
+		 const double* lo, const double* hi,
+		 double& t0, double& t1)
+  {
+    t0 = 0.;
+    t1 = 1.;
+    for(int a = 0; a < 3; ++a){
+      const double d = p1[a] - p0[a];
+      if(d == 0.){
+	if(p0[a] < lo[a] || p0[a] > hi[a]) return false;
+	continue;
+      }
+      double ta = (lo[a] - p0[a])/d;
+      double tb = (hi[a] - p0[a])/d;
+      if(ta > tb) std::swap(ta, tb);
+      t0 = std::max(t0, ta);
+      t1 = std::min(t1, tb);
+      if(t0 > t1) return false;
+    }
+
+    return true;
+  }
+
+}
+
+namespace simb{
+
+  //......................................................................
+  MCSegmentIndex::MCSegmentIndex()
+  {
+    this->Build();
+  }
+
+  //......................................................................
+  MCSegmentIndex::MCSegmentIndex(std::vector<simb::MCParticle> const& particles,
+				 double cellSize)
+  {
+    for(size_t i = 0; i < particles.size(); ++i) this->Add(particles[i]);
+    this->Build(cellSize);
+  }
+
+  //......................................................................
+  void MCSegmentIndex::Clear()
+  {
+    fX0     .clear();
+    fY0     .clear();
+    fZ0     .clear();
+    fX1     .clear();
+    fY1     .clear();
+    fZ1     .clear();
+    fTrackId.clear();
+    fSegment.clear();
+    this->Build();
+  }
+
+  //......................................................................
+  void MCSegmentIndex::Add(simb::MCParticle const& particle)
+  {
+    const simb::MCTrajectory& traj = particle.Trajectory();
+    const unsigned int npts = traj.size();
+    if(npts == 0) return;
+
+    // a single point still tells where the particle is
+    const unsigned int nseg = (npts > 1) ? npts-1 : 1;
+    for(unsigned int i = 0; i < nseg; ++i){
+      const unsigned int j = (npts > 1) ? i+1 : i;
+      fX0.push_back(traj.X(i));
+      fY0.push_back(traj.Y(i));
+      fZ0.push_back(traj.Z(i));
+      fX1.push_back(traj.X(j));
+      fY1.push_back(traj.Y(j));
+      fZ1.push_back(traj.Z(j));
+      fTrackId.push_back(particle.TrackId());
+      fSegment.push_back(i);
+    }
+
+    return;
+  }
+
+  //......................................................................
+  void MCSegmentIndex::Build(double cellSize)
+  {
+    const size_t n = this->NSegments();
+
+    fCellBegin.clear();
+    fCellSegs .clear();
+
+    if(n == 0){
+      for(int a = 0; a < 3; ++a){ fLo[a] = 0.; fCell[a] = 1.; fN[a] = 1; }
+      fCellBegin.assign(2, 0);
+      return;
+    }
+
+    // bounding box of all the segments
+    double lo[3] = { fX0[0], fY0[0], fZ0[0] };
+    double hi[3] = { fX0[0], fY0[0], fZ0[0] };
+    for(size_t s = 0; s < n; ++s){
+      const double x[2] = { fX0[s], fX1[s] };
+      const double y[2] = { fY0[s], fY1[s] };
+      const double z[2] = { fZ0[s], fZ1[s] };
+      for(int e = 0; e < 2; ++e){
+	lo[0] = std::min(lo[0], x[e]); hi[0] = std::max(hi[0], x[e]);
+	lo[1] = std::min(lo[1], y[e]); hi[1] = std::max(hi[1], y[e]);
+	lo[2] = std::min(lo[2], z[e]); hi[2] = std::max(hi[2], z[e]);
+      }
+    }
+
+    double ext[3];
+    double emax = 0.;
+    for(int a = 0; a < 3; ++a){
+      ext[a] = hi[a] - lo[a];
+      emax   = std::max(emax, ext[a]);
+    }
+
+    double h = cellSize;
+    if(h <= 0.){
+      if(emax <= 0.) h = 1.;
+      else{
+	// about one segment per cell; flat events (a single straight track,
+	// say) are treated as slightly thick so the volume is not zero
+	const double thin = 1.e-3*emax;
+	const double vol  = std::max(ext[0], thin)*std::max(ext[1], thin)*std::max(ext[2], thin);
+	h = std::cbrt(vol/n);
+      }
+    }
+
+    int ncell = 1;
+    for(int a = 0; a < 3; ++a){
+      const double nd = std::ceil(ext[a]/h);
+      fLo[a]   = lo[a];
+      fCell[a] = h;
+      fN[a]    = (nd > 1.) ? int(nd) : 1;
+      if(nd > kMaxCellsPerAxis){
+	fN[a]    = kMaxCellsPerAxis;
+	fCell[a] = ext[a]/kMaxCellsPerAxis;
+      }
+      ncell *= fN[a];
+    }
+
+    // list the cells each segment passes through, then group by cell
+    std::vector<int> pairCell;
+    std::vector<int> pairSeg;
+    std::vector<int> cells;
+    pairCell.reserve(2*n);
+    pairSeg .reserve(2*n);
+    for(size_t s = 0; s < n; ++s){
+      const double p0[3] = { fX0[s], fY0[s], fZ0[s] };
+      const double p1[3] = { fX1[s], fY1[s], fZ1[s] };
+      cells.clear();
+      this->Traverse(p0, p1, cells);
+      for(size_t c = 0; c < cells.size(); ++c){
+	pairCell.push_back(cells[c]);
+	pairSeg .push_back(s);
+      }
+    }
+
+    fCellBegin.assign(ncell+1, 0);
+    for(size_t i = 0; i < pairCell.size(); ++i) ++fCellBegin[pairCell[i]+1];
+    for(int c = 0; c < ncell; ++c) fCellBegin[c+1] += fCellBegin[c];
+
+    std::vector<int> fill(fCellBegin.begin(), fCellBegin.end()-1);
+    fCellSegs.resize(pairCell.size());
+    for(size_t i = 0; i < pairCell.size(); ++i)
+      fCellSegs[fill[pairCell[i]]++] = pairSeg[i];
+
+    return;
+  }
+
+  //......................................................................
+  void MCSegmentIndex::Box(double xlo, double xhi,
+			   double ylo, double yhi,
+			   double zlo, double zhi,
+			   std::vector<simb::MCSegmentHit>& hits) const
+  {
+    hits.clear();
+    if(this->NSegments() == 0) return;
+
+    const double lo[3] = { xlo, ylo, zlo };
+    const double hi[3] = { xhi, yhi, zhi };
+    int clo[3];
+    int chi[3];
+    for(int a = 0; a < 3; ++a){
+      // every segment lies inside the grid
+      if(hi[a] < fLo[a] || lo[a] > fLo[a] + fN[a]*fCell[a] || lo[a] > hi[a]) return;
+      clo[a] = this->CellIndex(lo[a], a);
+      chi[a] = this->CellIndex(hi[a], a);
+    }
+
+    std::vector<int> segs;
+    for(int ix = clo[0]; ix <= chi[0]; ++ix)
+      for(int iy = clo[1]; iy <= chi[1]; ++iy)
+	for(int iz = clo[2]; iz <= chi[2]; ++iz)
+	  this->CellSegments(ix, iy, iz, segs);
+
+    std::sort(segs.begin(), segs.end());
+    segs.erase(std::unique(segs.begin(), segs.end()), segs.end());
+
+    for(size_t i = 0; i < segs.size(); ++i){
+      const int    s     = segs[i];
+      const double p0[3] = { fX0[s], fY0[s], fZ0[s] };
+      const double p1[3] = { fX1[s], fY1[s], fZ1[s] };
+      double t0, t1;
+      if( !ClipToBox(p0, p1, lo, hi, t0, t1) ) continue;
+
+      MCSegmentHit hit;
+      hit.fTrackId  = fTrackId[s];
+      hit.fSegment  = fSegment[s];
+      hit.fDistance = 0.;
+      hits.push_back(hit);
+    }
+
+    return;
+  }
+
+  //......................................................................
+  void MCSegmentIndex::Ray(const double* start, const double* dir,
+			   double length, double radius,
+			   std::vector<simb::MCSegmentHit>& hits) const
+  {
+    hits.clear();
+    if(this->NSegments() == 0 || length < 0. || radius < 0.) return;
+
+    const double norm = std::sqrt(dir[0]*dir[0] + dir[1]*dir[1] + dir[2]*dir[2]);
+    const double step = (norm > 0.) ? length/norm : 0.;
+    const double q0[3] = { start[0], start[1], start[2] };
+    const double q1[3] = { start[0] + step*dir[0],
+			   start[1] + step*dir[1],
+			   start[2] + step*dir[2] };
+
+    // only the part of the ray near the grid can find anything
+    double lo[3];
+    double hi[3];
+    for(int a = 0; a < 3; ++a){
+      lo[a] = fLo[a] - radius;
+      hi[a] = fLo[a] + fN[a]*fCell[a] + radius;
+    }
+    double t0, t1;
+    if( !ClipToBox(q0, q1, lo, hi, t0, t1) ) return;
+
+    // Pull the ends of the clipped ray into the grid.  That moves them by
+    // at most radius along each axis, and the path between them by at
+    // most twice that, so cells within three radii of the path cover
+    // everything within radius of the ray.
+    double c0[3];
+    double c1[3];
+    int    reach[3];
+    for(int a = 0; a < 3; ++a){
+      const double top = fLo[a] + fN[a]*fCell[a];
+      c0[a] = std::min(std::max(q0[a] + t0*(q1[a] - q0[a]), fLo[a]), top);
+      c1[a] = std::min(std::max(q0[a] + t1*(q1[a] - q0[a]), fLo[a]), top);
+      reach[a] = int(std::min(double(fN[a]), std::ceil(3.*radius/fCell[a])));
+    }
+
+    std::vector<int> path;
+    this->Traverse(c0, c1, path);
+
+    std::vector<int> cells;
+    for(size_t i = 0; i < path.size(); ++i){
+      const int ix = path[i] % fN[0];
+      const int iy = (path[i] / fN[0]) % fN[1];
+      const int iz = path[i] / (fN[0]*fN[1]);
+      for(int jx = std::max(ix-reach[0], 0); jx <= std::min(ix+reach[0], fN[0]-1); ++jx)
+	for(int jy = std::max(iy-reach[1], 0); jy <= std::min(iy+reach[1], fN[1]-1); ++jy)
+	  for(int jz = std::max(iz-reach[2], 0); jz <= std::min(iz+reach[2], fN[2]-1); ++jz)
+	    cells.push_back(this->Cell(jx, jy, jz));
+    }
+    std::sort(cells.begin(), cells.end());
+    cells.erase(std::unique(cells.begin(), cells.end()), cells.end());
+
+    std::vector<int> segs;
+    for(size_t i = 0; i < cells.size(); ++i)
+      segs.insert(segs.end(),
+		  fCellSegs.begin() + fCellBegin[cells[i]],
+		  fCellSegs.begin() + fCellBegin[cells[i]+1]);
+    std::sort(segs.begin(), segs.end());
+    segs.erase(std::unique(segs.begin(), segs.end()), segs.end());
+
+    const double r2 = radius*radius;
+    for(size_t i = 0; i < segs.size(); ++i){
+      const int    s  = segs[i];
+      const double d2 = this->SegmentDistance2(s, q0, q1);
+      if(d2 > r2) continue;
+
+      MCSegmentHit hit;
+      hit.fTrackId  = fTrackId[s];
+      hit.fSegment  = fSegment[s];
+      hit.fDistance = std::sqrt(d2);
+      hits.push_back(hit);
+    }
+
+    std::sort(hits.begin(), hits.end(), HitLess);
+
+    return;
+  }
+
+  //......................................................................
+  bool MCSegmentIndex::Nearest(double x, double y, double z,
+			       simb::MCSegmentHit& hit) const
+  {
+    if(this->NSegments() == 0) return false;
+
+    const double p[3] = { x, y, z };
+    const int    c[3] = { this->CellIndex(x, 0),
+			  this->CellIndex(y, 1),
+			  this->CellIndex(z, 2) };
+    const double hmin = std::min(fCell[0], std::min(fCell[1], fCell[2]));
+    const int    kmax = std::max(fN[0], std::max(fN[1], fN[2]));
+
+    double best    = std::numeric_limits<double>::max();
+    int    bestSeg = -1;
+
+    // Search shells of cells further and further out from the point's
+    // cell.  Once shells 0..k are done, every segment within k*hmin of
+    // the point has been seen.
+    std::vector<int> segs;
+    for(int k = 0; k <= kmax; ++k){
+      segs.clear();
+      for(int ix = std::max(c[0]-k, 0); ix <= std::min(c[0]+k, fN[0]-1); ++ix){
+	for(int iy = std::max(c[1]-k, 0); iy <= std::min(c[1]+k, fN[1]-1); ++iy){
+	  if(std::abs(ix-c[0]) == k || std::abs(iy-c[1]) == k){
+	    for(int iz = std::max(c[2]-k, 0); iz <= std::min(c[2]+k, fN[2]-1); ++iz)
+	      this->CellSegments(ix, iy, iz, segs);
+	  }
+	  else{
+	    if(c[2]-k >= 0)     this->CellSegments(ix, iy, c[2]-k, segs);
+	    if(c[2]+k <  fN[2]) this->CellSegments(ix, iy, c[2]+k, segs);
+	  }
+	}
+      }
+
+      for(size_t i = 0; i < segs.size(); ++i){
+	const double d2 = this->PointDistance2(segs[i], p);
+	if(d2 < best || (d2 == best && segs[i] < bestSeg)){
+	  best    = d2;
+	  bestSeg = segs[i];
+	}
+      }
+
+      if(bestSeg >= 0 && best <= (k*hmin)*(k*hmin)) break;
+    }
+
+    hit.fTrackId  = fTrackId[bestSeg];
+    hit.fSegment  = fSegment[bestSeg];
+    hit.fDistance = std::sqrt(best);
+
+    return true;
+  }
+
+  //......................................................................
+  int MCSegmentIndex::CellIndex(double v, int axis) const
+  {
+    const double f = (v - fLo[axis])/fCell[axis];
+    if( !(f > 0.) ) return 0;
+    if(f >= fN[axis]) return fN[axis]-1;
+    return int(f);
+  }
+
+  //......................................................................
+  int MCSegmentIndex::Cell(int ix, int iy, int iz) const
+  {
+    return ix + fN[0]*(iy + fN[1]*iz);
+  }
+
+  //......................................................................
+  void MCSegmentIndex::CellSegments(int ix, int iy, int iz,
+				    std::vector<int>& segs) const
+  {
+    const int c = this->Cell(ix, iy, iz);
+    segs.insert(segs.end(),
+		fCellSegs.begin() + fCellBegin[c],
+		fCellSegs.begin() + fCellBegin[c+1]);
+  }
+
+  //......................................................................
+  // Append the cells the straight line p0-p1 passes through, in order,
+  // stepping from one cell to the next across whichever face the line
+  // reaches first (Amanatides and Woo).  Each step moves one cell closer
+  // to the cell of p1, so the walk always ends there.
+  void MCSegmentIndex::Traverse(const double* p0, const double* p1,
+				std::vector<int>& cells) const
+  {
+    int    ix[3];
+    int    iend[3];
+    int    step[3];
+    double tMax[3];
+    double tDelta[3];
+    int    nstep = 0;
+    for(int a = 0; a < 3; ++a){
+      ix[a]   = this->CellIndex(p0[a], a);
+      iend[a] = this->CellIndex(p1[a], a);
+      step[a] = (iend[a] > ix[a]) ? 1 : ((iend[a] < ix[a]) ? -1 : 0);
+      if(step[a] == 0){
+	tMax[a] = tDelta[a] = std::numeric_limits<double>::max();
+	continue;
+      }
+      const double d        = p1[a] - p0[a];
+      const double boundary = fLo[a] + (ix[a] + (step[a] > 0))*fCell[a];
+      tMax[a]   = (boundary - p0[a])/d;
+      tDelta[a] = fCell[a]/std::abs(d);
+      nstep    += std::abs(iend[a] - ix[a]);
+    }
+
+    cells.push_back(this->Cell(ix[0], ix[1], ix[2]));
+    for(int i = 0; i < nstep; ++i){
+      int a = -1;
+      for(int b = 0; b < 3; ++b)
+	if(ix[b] != iend[b] && (a < 0 || tMax[b] < tMax[a])) a = b;
+
+      ix[a]   += step[a];
+      tMax[a] += tDelta[a];
+      cells.push_back(this->Cell(ix[0], ix[1], ix[2]));
+    }
+
+    return;
+  }
+
+  //......................................................................
+  double MCSegmentIndex::PointDistance2(int seg, const double* p) const
+  {
+    const double d[3] = { fX1[seg] - fX0[seg], fY1[seg] - fY0[seg], fZ1[seg] - fZ0[seg] };
+    const double w[3] = { p[0]     - fX0[seg], p[1]     - fY0[seg], p[2]     - fZ0[seg] };
+    const double dd   = d[0]*d[0] + d[1]*d[1] + d[2]*d[2];
+
+    double t = 0.;
+    if(dd > 0.) t = std::min(std::max((w[0]*d[0] + w[1]*d[1] + w[2]*d[2])/dd, 0.), 1.);
+
+    const double e[3] = { w[0] - t*d[0], w[1] - t*d[1], w[2] - t*d[2] };
+    return e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
+  }
+
+  //......................................................................
+  // Squared distance between the closest points of the segment and the
+  // segment p0-p1, after Ericson, Real-Time Collision Detection, 5.1.9.
+  double MCSegmentIndex::SegmentDistance2(int seg, const double* p0, const double* p1) const
+  {
+    const double d1[3] = { fX1[seg] - fX0[seg], fY1[seg] - fY0[seg], fZ1[seg] - fZ0[seg] };
+    const double d2[3] = { p1[0]    - p0[0],    p1[1]    - p0[1],    p1[2]    - p0[2]    };
+    const double r[3]  = { fX0[seg] - p0[0],    fY0[seg] - p0[1],    fZ0[seg] - p0[2]    };
+
+    const double a = d1[0]*d1[0] + d1[1]*d1[1] + d1[2]*d1[2];
+    const double e = d2[0]*d2[0] + d2[1]*d2[1] + d2[2]*d2[2];
+    const double f = d2[0]*r[0]  + d2[1]*r[1]  + d2[2]*r[2];
+
+    double s = 0.;
+    double t = 0.;
+    if(a <= 0. && e <= 0.){
+      // both are points
+    }
+    else if(a <= 0.){
+      t = std::min(std::max(f/e, 0.), 1.);
+    }
+    else{
+      const double c = d1[0]*r[0] + d1[1]*r[1] + d1[2]*r[2];
+      if(e <= 0.){
+	s = std::min(std::max(-c/a, 0.), 1.);
+      }
+      else{
+	const double b     = d1[0]*d2[0] + d1[1]*d2[1] + d1[2]*d2[2];
+	const double denom = a*e - b*b;
+	if(denom > 0.) s = std::min(std::max((b*f - c*e)/denom, 0.), 1.);
+
+	t = (b*s + f)/e;
+	if(t < 0.){
+	  t = 0.;
+	  s = std::min(std::max(-c/a, 0.), 1.);
+	}
+	else if(t > 1.){
+	  t = 1.;
+	  s = std::min(std::max((b - c)/a, 0.), 1.);
+	}
+      }
+    }
+
+    const double w[3] = { r[0] + s*d1[0] - t*d2[0],
+			  r[1] + s*d1[1] - t*d2[1],
+			  r[2] + s*d1[2] - t*d2[2] };
+    return w[0]*w[0] + w[1]*w[1] + w[2]*w[2];
+  }
+
+} // namespace simb
@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCSegmentIndex.h
+/// \brief Spatial lookup of the trajectory segments of an event's particles
+////////////////////////////////////////////////////////////////////////
+
+/// Back-tracking and display code keeps asking which particles pass
+/// through some region of the detector.  Walking every trajectory
+/// point of every particle to answer that is slow for big events, so
+/// this class sorts the straight segments joining consecutive
+/// trajectory points into a uniform grid of cells, once per event.
+/// A query then only looks at the segments in the cells it touches.
+///
+/// A segment is identified by the track ID of its particle and its
+/// number along the trajectory: segment i joins points i and i+1.  A
+/// particle with a single trajectory point contributes one segment of
+/// zero length, number 0.
+///
+/// Typical use:
+///
+///     simb::MCSegmentIndex index(particles);     // once per event
+///     std::vector<simb::MCSegmentHit> hits;
+///     index.Box(x1, x2, y1, y2, z1, z2, hits);  // who crosses this voxel?
+///
+/// The grid cell size is chosen so that there is about one segment per
+/// cell, unless one is given.  Positions are in the trajectory units.
+
+#ifndef SIMB_MCSEGMENTINDEX_H
+#define SIMB_MCSEGMENTINDEX_H
+
+#include <vector>
+#include <cstddef>
+
+namespace simb {
+
+  class MCParticle;
+
+  /// A trajectory segment found by an MCSegmentIndex query
+  class MCSegmentHit {
+  public:
+    int    fTrackId;  ///< track ID of the particle
+    int    fSegment;  ///< segment i joins trajectory points i and i+1
+    double fDistance; ///< distance from the query point or ray; 0 for box queries
+  };
+
+  class MCSegmentIndex {
+  public:
+
+    MCSegmentIndex();
+
+    /// Index the trajectories of the given particles.
+    explicit MCSegmentIndex(std::vector<simb::MCParticle> const& particles,
+			    double cellSize = 0.);
+
+    void   Clear();
+    void   Add(simb::MCParticle const& particle); ///< add a particle's segments; call Build() when done
+    void   Build(double cellSize = 0.);           ///< sort the segments added so far into the grid
+
+    size_t NSegments() const;
+
+    /// Segments with any part inside the box.  Each segment appears once.
+    void   Box(double xlo, double xhi,
+	       double ylo, double yhi,
+	       double zlo, double zhi,
+	       std::vector<simb::MCSegmentHit>& hits) const;
+
+    /// Segments passing within radius of the ray from start[3] along
+    /// dir[3] for the given length; dir need not be a unit vector.  Hits
+    /// are sorted by their distance from the ray.
+    void   Ray(const double* start, const double* dir,
+	       double length, double radius,
+	       std::vector<simb::MCSegmentHit>& hits) const;
+
+    /// The segment closest to the point; false if there are no segments.
+    bool   Nearest(double x, double y, double z,
+		   simb::MCSegmentHit& hit) const;
+
+  private:
+
+    int    CellIndex(double v, int axis)   const;
+    int    Cell(int ix, int iy, int iz)    const;
+    void   CellSegments(int ix, int iy, int iz,
+			std::vector<int>& segs) const;
+    void   Traverse(const double* p0, const double* p1,
+		    std::vector<int>& cells) const;
+    double PointDistance2(int seg, const double* p) const;
+    double SegmentDistance2(int seg, const double* p0, const double* p1) const;
+
+    // the segments, one entry per segment
+    std::vector<double> fX0, fY0, fZ0; ///< start of each segment
+    std::vector<double> fX1, fY1, fZ1; ///< end of each segment
+    std::vector<int>    fTrackId;      ///< track ID of the particle each segment belongs to
+    std::vector<int>    fSegment;      ///< number of each segment along its trajectory
+
+    // the grid
+    double              fLo[3];        ///< low corner of the grid
+    double              fCell[3];      ///< cell size along each axis
+    int                 fN[3];         ///< number of cells along each axis
+    std::vector<int>    fCellBegin;    ///< where each cell's segments start in fCellSegs
+    std::vector<int>    fCellSegs;     ///< segments in each cell, grouped by cell
+  };
+
+} // namespace simb
+
+inline size_t simb::MCSegmentIndex::NSegments() const { return fTrackId.size(); }
+
+#endif // SIMB_MCSEGMENTINDEX_H
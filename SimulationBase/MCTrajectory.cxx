@@ -8,9 +8,11 @@
 #include "cetlib/exception.h"
 
 #include "SimulationBase/MCTrajectory.h"
+#include "SimulationBase/MCTrajectoryCodec.h"
 
 #include <TLorentzVector.h>
 
+#include <algorithm>
 #include <cmath>
 #include <deque>
 #include <iterator>
@@ -20,42 +22,122 @@ namespace simb {
 
   // Nothing special need be done for the default constructor or destructor.
   MCTrajectory::MCTrajectory() 
-    : ftrajectory()
+    : fx()
+    , fy()
+    , fz()
+    , ft()
+    , fpx()
+    , fpy()
+    , fpz()
+    , fe()
+    , fpacked()
+    , fdroppedx()
+    , fdroppedy()
+    , fdroppedz()
   {}
 
   //----------------------------------------------------------------------------
   MCTrajectory::MCTrajectory( const TLorentzVector& position, 
 			      const TLorentzVector& momentum )
   {
-    ftrajectory.push_back( value_type( position, momentum ) );
+    push_back( position, momentum );
   }
 
   //----------------------------------------------------------------------------
-  const TLorentzVector& MCTrajectory::Position( const size_type index ) const
+  MCTrajectory::value_type MCTrajectory::at( const size_type index ) const
   {
-    const_iterator i = ftrajectory.begin();
-    std::advance(i,index);
-    return (*i).first;
+    if(index >= size())
+      throw cet::exception("MCTrajectory") << "index " << index 
+					   << " out of range for trajectory with " 
+					   << size() << " points";
+
+    return (*this)[index];
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::Append( const TLorentzVector& p, 
+			     const TLorentzVector& m )
+  {
+    fx .push_back(p.X());
+    fy .push_back(p.Y());
+    fz .push_back(p.Z());
+    ft .push_back(p.T());
+    fpx.push_back(m.Px());
+    fpy.push_back(m.Py());
+    fpz.push_back(m.Pz());
+    fe .push_back(m.E());
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::ClearDropped()
+  {
+    fdroppedx.clear();
+    fdroppedy.clear();
+    fdroppedz.clear();
   }
 
   //----------------------------------------------------------------------------
-  const TLorentzVector& MCTrajectory::Momentum( const size_type index ) const
+  void MCTrajectory::reserve( const size_type n )
   {
-    const_iterator i = ftrajectory.begin();
-    std::advance(i,index);
-    return (*i).second;
+    fx .reserve(n);
+    fy .reserve(n);
+    fz .reserve(n);
+    ft .reserve(n);
+    fpx.reserve(n);
+    fpy.reserve(n);
+    fpz.reserve(n);
+    fe .reserve(n);
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::clear()
+  {
+    fx .clear();
+    fy .clear();
+    fz .clear();
+    ft .clear();
+    fpx.clear();
+    fpy.clear();
+    fpz.clear();
+    fe .clear();
+    fpacked.clear();
+    ClearDropped();
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::swap( simb::MCTrajectory& other )
+  {
+    fx .swap(other.fx);
+    fy .swap(other.fy);
+    fz .swap(other.fz);
+    ft .swap(other.ft);
+    fpx.swap(other.fpx);
+    fpy.swap(other.fpy);
+    fpz.swap(other.fpz);
+    fe .swap(other.fe);
+    fpacked.swap(other.fpacked);
+    fdroppedx.swap(other.fdroppedx);
+    fdroppedy.swap(other.fdroppedy);
+    fdroppedz.swap(other.fdroppedz);
   }
 
   //----------------------------------------------------------------------------
   double MCTrajectory::TotalLength() const
   {
-    const int N = size();
+    const size_type N = size();
     if(N < 2) return 0;
 
+    const double* x = &fx[0];
+    const double* y = &fy[0];
+    const double* z = &fz[0];
+
     // We take the sum of the straight lines between the trajectory points
     double dist = 0;
-    for(int n = 0; n < N-1; ++n){
-      dist += (Position(n+1)-Position(n)).Vect().Mag();
+    for(size_type n = 1; n < N; ++n){
+      const double dx = x[n] - x[n-1];
+      const double dy = y[n] - y[n-1];
+      const double dz = z[n] - z[n-1];
+      dist += std::sqrt(dx*dx + dy*dy + dz*dz);
     }
 
     return dist;
@@ -73,19 +155,18 @@ namespace simb {
     output << "#" << ": < position (x,y,z,t), momentum (Px,Py,Pz,E) >" << std::endl; 
 
     // Write each trajectory point on a separate line.
-    MCTrajectory::size_type nTrajectory = 0;
-    for ( MCTrajectory::const_iterator trajectory = list.begin(); trajectory != list.end(); ++trajectory, ++nTrajectory )
+    for ( MCTrajectory::size_type n = 0; n < numberOfTrajectories; ++n )
       {
 	output.width( numberOfDigits );
-	output << nTrajectory << ": " 
-	       << "< (" << (*trajectory).first.X() 
-	       << "," << (*trajectory).first.Y() 
-	       << "," << (*trajectory).first.Z() 
-	       << "," << (*trajectory).first.T() 
-	       << ") , (" << (*trajectory).second.Px() 
-	       << "," << (*trajectory).second.Py() 
-	       << "," << (*trajectory).second.Pz() 
-	       << "," << (*trajectory).second.E() 
+	output << n << ": " 
+	       << "< (" << list.X(n) 
+	       << "," << list.Y(n) 
+	       << "," << list.Z(n) 
+	       << "," << list.T(n) 
+	       << ") , (" << list.Px(n) 
+	       << "," << list.Py(n) 
+	       << "," << list.Pz(n) 
+	       << "," << list.E(n) 
 	       << ") >" << std::endl;
       }
 
@@ -106,9 +187,16 @@ namespace simb {
     // Need at least three points to think of removing one
     if(size() <= 2) return;
 
+    // Whatever AddSparsified() was keeping track of refers to the old indices
+    ClearDropped();
+
     // Deal in terms of distance-squared to save some sqrts
     margin *= margin;
 
+    const double* x = &fx[0];
+    const double* y = &fy[0];
+    const double* z = &fz[0];
+
     // Deque because we add things still to check on the end, and pop things
     // we've checked from the front.
     std::deque<std::pair<int, int> > toCheck;
@@ -127,17 +215,31 @@ namespace simb {
       if(hiIdx < loIdx+2)
 	throw cet::exception("MCTrajectory") << "Degnerate range in Sparsify method";
 
-      const TVector3 loVec = at(loIdx).first.Vect();
-      const TVector3 hiVec = at(hiIdx).first.Vect();
-
-      const TVector3 dir = (hiVec-loVec).Unit();
+      // Unit vector along the line joining the endpoints; left as zero if
+      // the endpoints coincide, as TVector3::Unit() does
+      double dirX = x[hiIdx] - x[loIdx];
+      double dirY = y[hiIdx] - y[loIdx];
+      double dirZ = z[hiIdx] - z[loIdx];
+      const double dirMag2 = dirX*dirX + dirY*dirY + dirZ*dirZ;
+      if(dirMag2 > 0){
+	const double invMag = 1./std::sqrt(dirMag2);
+	dirX *= invMag;
+	dirY *= invMag;
+	dirZ *= invMag;
+      }
 
       // Are all the points in between close enough?
       bool ok = true;
       for(int i = loIdx+1; i < hiIdx; ++i){
-	const TVector3 toHere = at(i).first.Vect()-loVec;
-	// Perpendicular distance^2 from the line joining loVec to hiVec
-	const double impact = (toHere-dir.Dot(toHere)*dir).Mag2();
+	const double toX = x[i] - x[loIdx];
+	const double toY = y[i] - y[loIdx];
+	const double toZ = z[i] - z[loIdx];
+	// Perpendicular distance^2 from the line joining the endpoints
+	const double proj = dirX*toX + dirY*toY + dirZ*toZ;
+	const double impX = toX - proj*dirX;
+	const double impY = toY - proj*dirY;
+	const double impZ = toZ - proj*dirZ;
+	const double impact = impX*impX + impY*impY + impZ*impZ;
 	if(impact > margin){ok = false; break;}
       }
 
@@ -177,17 +279,129 @@ namespace simb {
     // We end up with them in a somewhat-randomized order
     std::sort(done.begin(), done.end());
 
-    // Look up the trajectory points at the stored indices, write them to a new
-    // trajectory
-    const unsigned int I = done.size();
-    list_type newTraj;
-    newTraj.reserve(I+1);
-    for(unsigned int i = 0; i < I; ++i) newTraj.push_back(at(done[i]));
-    // Remember to add the very last point in
-    newTraj.push_back(*rbegin());
-
-    // Replace trajectory with new version
-    ftrajectory = newTraj;
+    // Remember to keep the very last point
+    done.push_back(size()-1);
+
+    // The kept indices are increasing, so each point can be moved down to
+    // its new position in place
+    const size_type I = done.size();
+    component_type* const components[8] = { &fx, &fy, &fz, &ft, &fpx, &fpy, &fpz, &fe };
+    for(int c = 0; c < 8; ++c){
+      component_type& v = *components[c];
+      for(size_type i = 0; i < I; ++i) v[i] = v[done[i]];
+      component_type(v.begin(), v.begin()+I).swap(v);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::AddSparsified( const TLorentzVector& p, 
+				    const TLorentzVector& m,
+				    double                margin,
+				    size_type             window )
+  {
+    // The last point is only a candidate for removal; the one before it was
+    // kept for good when the last point was added. Without both there is
+    // nothing to drop yet.
+    const size_type N = size();
+    if(N < 2 || fdroppedx.size() >= window){
+      ClearDropped();
+      Append(p, m);
+      return;
+    }
+
+    // Deal in terms of distance-squared to save some sqrts
+    margin *= margin;
+
+    const double loX = fx[N-2];
+    const double loY = fy[N-2];
+    const double loZ = fz[N-2];
+
+    // Unit vector along the line from the kept point to the new one; left as
+    // zero if they coincide, as in Sparsify()
+    double dirX = p.X() - loX;
+    double dirY = p.Y() - loY;
+    double dirZ = p.Z() - loZ;
+    const double dirMag2 = dirX*dirX + dirY*dirY + dirZ*dirZ;
+    if(dirMag2 > 0){
+      const double invMag = 1./std::sqrt(dirMag2);
+      dirX *= invMag;
+      dirY *= invMag;
+      dirZ *= invMag;
+    }
+
+    // The candidate goes on the end of the dropped list for the check, and
+    // only stays there if every point passes.
+    fdroppedx.push_back(fx[N-1]);
+    fdroppedy.push_back(fy[N-1]);
+    fdroppedz.push_back(fz[N-1]);
+
+    const size_type D = fdroppedx.size();
+    bool ok = true;
+    for(size_type i = 0; i < D; ++i){
+      const double toX = fdroppedx[i] - loX;
+      const double toY = fdroppedy[i] - loY;
+      const double toZ = fdroppedz[i] - loZ;
+      // Perpendicular distance^2 from the line
+      const double proj = dirX*toX + dirY*toY + dirZ*toZ;
+      const double impX = toX - proj*dirX;
+      const double impY = toY - proj*dirY;
+      const double impZ = toZ - proj*dirZ;
+      if(impX*impX + impY*impY + impZ*impZ > margin){ok = false; break;}
+    }
+
+    if(ok){
+      // Replace the candidate with the new point
+      fx [N-1] = p.X();
+      fy [N-1] = p.Y();
+      fz [N-1] = p.Z();
+      ft [N-1] = p.T();
+      fpx[N-1] = m.Px();
+      fpy[N-1] = m.Py();
+      fpz[N-1] = m.Pz();
+      fe [N-1] = m.E();
+    }
+    else{
+      // The candidate has to stay, so it becomes the new kept point
+      ClearDropped();
+      Append(p, m);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::Pack( simb::MCTrajectoryCodec const& codec )
+  {
+    // already in packed form, e.g. read back and never unpacked
+    if( this->IsPacked() || this->empty() ) return;
+
+    // format version, number of points, then each component in turn
+    MCTrajectoryCodec::PutVarint(1, fpacked);
+    MCTrajectoryCodec::PutVarint(size(), fpacked);
+
+    component_type* const components[8] = { &fx, &fy, &fz, &ft, &fpx, &fpy, &fpz, &fe };
+    for(int c = 0; c < 8; ++c) codec.Encode(*components[c], c, fpacked);
+
+    // only the encoding is to be written
+    for(int c = 0; c < 8; ++c) component_type().swap(*components[c]);
+    ClearDropped();
+  }
+
+  //----------------------------------------------------------------------------
+  void MCTrajectory::Unpack()
+  {
+    if( !this->IsPacked() ) return;
+
+    size_t pos = 0;
+    const unsigned long long version = MCTrajectoryCodec::GetVarint(fpacked, pos);
+    if(version != 1)
+      throw cet::exception("MCTrajectory") << "unknown packed trajectory format " << version;
+
+    const size_type n = MCTrajectoryCodec::GetVarint(fpacked, pos);
+
+    component_type* const components[8] = { &fx, &fy, &fz, &ft, &fpx, &fpy, &fpz, &fe };
+    for(int c = 0; c < 8; ++c) MCTrajectoryCodec::Decode(fpacked, pos, n, *components[c]);
+
+    std::vector<unsigned char>().swap(fpacked);
+    ClearDropped();
   }
 
 } // namespace sim
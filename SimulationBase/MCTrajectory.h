@@ -21,7 +21,7 @@
 ///           TLorentzVector position = trajectory->Position(i);
 ///           TLorentzVector momentum = trajectory->Momentum(i);
 ///        }
-///   The STL equivalent to the above statements (more efficient):
+///   The STL equivalent to the above statements:
 ///      sim::Trajectory* trajectory = simb::MCParticle.Trajectory();
 ///      for ( sim::Trajectory::const_iterator i = trajectory->begin();
 ///            i != trajectory->end(); ++i )
@@ -31,7 +31,8 @@
 ///        }
 
 /// - As above, but for each position or momentum component; e.g.,
-///   trajectory->X(i).
+///   trajectory->X(i).  These are the cheapest accessors, since they
+///   read the stored value directly.
 
 /// - In addition to push_back(pair< TLorentzVector, TLorentzVector>),
 ///   there's also push_back(TLorentzVector,TLorentzVector) and
@@ -41,6 +42,22 @@
 /// - Print() and operator<< methods for ROOT display and ease of
 ///   debugging.
 
+/// The points are stored as one contiguous array per component
+/// (x,y,z,t,px,py,pz,E) rather than as pairs of TLorentzVectors, which
+/// carry TObject overhead and cost twice as much memory per point.
+/// Because of this, Position(), Momentum(), operator[] and the
+/// iterators hand back the TLorentzVectors by value; binding them to
+/// a const reference as in the example above is still fine.  Files
+/// written with the old vector< pair<TLorentzVector,TLorentzVector> >
+/// layout (class version 11) are converted on read by a schema
+/// evolution rule in classes_def.xml.
+
+/// To make files smaller, the points can be written in a compact
+/// encoding (see MCTrajectoryCodec).  The module making the particles
+/// packs their trajectories just before putting them into the event,
+/// after which they look empty until unpacked.  Packed trajectories
+/// are unpacked again when read back.
+
 /// There are no units defined in this class.  If it's used with
 /// Geant4, the units will be (mm,ns,GeV), but this class does not
 /// enforce this.
@@ -50,41 +67,112 @@
 
 #include <vector>
 #include <iostream>
+#include <iterator>
 
 #include <TLorentzVector.h>
 
 namespace simb {
 
+  class MCTrajectoryCodec;
+
   class MCTrajectory {
   public:
     /// Some type definitions to make life easier, and to help "hide"
     /// the implementation details.  (If you're not familiar with STL,
     /// you can ignore these definitions.)
-    typedef std::vector< std::pair<TLorentzVector, TLorentzVector> >  list_type;
-    typedef list_type::value_type                   value_type;
-    typedef list_type::iterator                     iterator;
-    typedef list_type::const_iterator               const_iterator;
-    typedef list_type::reverse_iterator             reverse_iterator;
-    typedef list_type::const_reverse_iterator       const_reverse_iterator;
-    typedef list_type::size_type                    size_type;
-    typedef list_type::difference_type              difference_type;
+    typedef std::vector<double>                              component_type;
+    typedef std::pair<TLorentzVector, TLorentzVector>        value_type;
+    typedef component_type::size_type                        size_type;
+    typedef component_type::difference_type                  difference_type;
 
     /// Standard constructor: Start with initial position and momentum
     /// of the particle.
     MCTrajectory();
 
   private:
-    list_type ftrajectory;
+    component_type fx;   ///< x position of each point
+    component_type fy;   ///< y position of each point
+    component_type fz;   ///< z position of each point
+    component_type ft;   ///< time of each point
+    component_type fpx;  ///< x momentum of each point
+    component_type fpy;  ///< y momentum of each point
+    component_type fpz;  ///< z momentum of each point
+    component_type fe;   ///< energy of each point
+
+    std::vector<unsigned char> fpacked; ///< the points as encoded on file, filled from Pack() until Unpack()
+
+    // Positions of the points dropped by AddSparsified() since the last point
+    // that is sure to be kept. Only needed while the trajectory is being built.
+    component_type fdroppedx;  //! transient
+    component_type fdroppedy;  //! transient
+    component_type fdroppedz;  //! transient
 
 #ifndef __GCCXML__
   public:
 
+    /// Random access iterator over the trajectory points.  Dereferencing
+    /// builds the (position,momentum) pair from the component arrays, so
+    /// it returns by value.
+    class const_iterator {
+    public:
+      typedef std::random_access_iterator_tag iterator_category;
+      typedef MCTrajectory::value_type        value_type;
+      typedef MCTrajectory::difference_type   difference_type;
+      typedef value_type                      reference;
+
+      /// Holds the pair returned by operator-> for as long as the
+      /// expression using it.
+      class pointer {
+      public:
+        explicit pointer(const value_type& v) : fValue(v) {}
+        const value_type* operator->() const { return &fValue; }
+      private:
+        value_type fValue;
+      };
+
+      const_iterator() : fTraj(0), fIndex(0) {}
+      const_iterator(const MCTrajectory* traj, size_type index) : fTraj(traj), fIndex(index) {}
+
+      reference       operator* ()                   const { return (*fTraj)[fIndex];                      }
+      pointer         operator->()                   const { return pointer((*fTraj)[fIndex]);             }
+      reference       operator[](difference_type n)  const { return (*fTraj)[fIndex+n];                    }
+      size_type       Index()                        const { return fIndex;                                }
+
+      const_iterator& operator++()                         { ++fIndex; return *this;                       }
+      const_iterator& operator--()                         { --fIndex; return *this;                       }
+      const_iterator  operator++(int)                      { const_iterator i(*this); ++fIndex; return i;  }
+      const_iterator  operator--(int)                      { const_iterator i(*this); --fIndex; return i;  }
+      const_iterator& operator+=(difference_type n)        { fIndex += n; return *this;                    }
+      const_iterator& operator-=(difference_type n)        { fIndex -= n; return *this;                    }
+      const_iterator  operator+ (difference_type n)  const { return const_iterator(fTraj, fIndex+n);       }
+      const_iterator  operator- (difference_type n)  const { return const_iterator(fTraj, fIndex-n);       }
+      difference_type operator- (const const_iterator& o) const
+      { return difference_type(fIndex) - difference_type(o.fIndex); }
+
+      bool operator==(const const_iterator& o) const { return fIndex == o.fIndex; }
+      bool operator!=(const const_iterator& o) const { return fIndex != o.fIndex; }
+      bool operator< (const const_iterator& o) const { return fIndex <  o.fIndex; }
+      bool operator> (const const_iterator& o) const { return fIndex >  o.fIndex; }
+      bool operator<=(const const_iterator& o) const { return fIndex <= o.fIndex; }
+      bool operator>=(const const_iterator& o) const { return fIndex >= o.fIndex; }
+
+    private:
+      const MCTrajectory* fTraj;
+      size_type           fIndex;
+    };
+
+    // Points can't be modified once added, so the non-const iterators
+    // are the same as the const ones.
+    typedef const_iterator                                  iterator;
+    typedef std::reverse_iterator<const_iterator>           const_reverse_iterator;
+    typedef const_reverse_iterator                          reverse_iterator;
+
     MCTrajectory( const TLorentzVector& vertex, 
 		  const TLorentzVector& momentum );
 
     /// The accessor methods described above.
-    const TLorentzVector& Position( const size_type ) const;
-    const TLorentzVector& Momentum( const size_type ) const;
+    TLorentzVector Position( const size_type ) const;
+    TLorentzVector Momentum( const size_type ) const;
     double  X( const size_type i ) const;
     double  Y( const size_type i ) const;
     double  Z( const size_type i ) const;
@@ -114,11 +202,12 @@ namespace simb {
     bool      empty()                   const;
     void      swap(simb::MCTrajectory& other);
     void      clear();
+    void      reserve(const size_type n);
 
     // Note that there's no non-const version of operator[] or at() here; once
     // you've added a point to a trajectory, you can't modify it.
-    const value_type& operator[](const size_type i) const;
-    const value_type& at(const size_type i)         const;
+    value_type operator[](const size_type i) const;
+    value_type at(const size_type i)         const;
 
     /// The only "set" methods for this class; once you've added a
     /// trajectory point, you can't take it back.
@@ -131,6 +220,33 @@ namespace simb {
     /// points.
     void Sparsify(double margin = .1);
 
+    /// Add a point, sparsifying as we go. The previous last point is
+    /// dropped if it, and every point dropped since the last point that was
+    /// kept, lies within \a margin of the straight line from that kept point
+    /// to the new one; this is the same guarantee Sparsify() gives. At most
+    /// \a window dropped points are remembered for the check; once that many
+    /// have been dropped the previous point is kept regardless.
+    void AddSparsified( const TLorentzVector& p, 
+			const TLorentzVector& m,
+			double                margin = .1,
+			size_type             window = 100 );
+
+    /// Replace the points with their encoding by the given codec, so
+    /// that only the encoding is written.  Until Unpack() the
+    /// trajectory looks empty.
+    void Pack(simb::MCTrajectoryCodec const& codec);
+
+    /// Restore the points from their encoding.  This is done when a
+    /// packed trajectory is read back; within the job that packed it,
+    /// unpack a copy to look at the points.
+    void Unpack();
+    bool IsPacked() const;
+
+  private:
+
+    void Append( const TLorentzVector& p, const TLorentzVector& m );
+    void ClearDropped();
+
 #endif
   };
 
@@ -138,41 +254,42 @@ namespace simb {
 
 #ifndef __GCCXML__
 
-inline double                 simb::MCTrajectory::X ( const size_type i ) const { return Position(i).X();      }
-inline double 		      simb::MCTrajectory::Y ( const size_type i ) const { return Position(i).Y();      }
-inline double 		      simb::MCTrajectory::Z ( const size_type i ) const { return Position(i).Z();      }
-inline double 		      simb::MCTrajectory::T ( const size_type i ) const { return Position(i).T();      }
-inline double 		      simb::MCTrajectory::Px( const size_type i ) const { return Momentum(i).Px();     }
-inline double 		      simb::MCTrajectory::Py( const size_type i ) const { return Momentum(i).Py();     }
-inline double 		      simb::MCTrajectory::Pz( const size_type i ) const { return Momentum(i).Pz();     }
-inline double 		      simb::MCTrajectory::E ( const size_type i ) const { return Momentum(i).E();      }
-
-inline simb::MCTrajectory::iterator               simb::MCTrajectory::begin()                   { return ftrajectory.begin();  }
-inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::begin()  		  const { return ftrajectory.begin();  }
-inline simb::MCTrajectory::iterator               simb::MCTrajectory::end()    		        { return ftrajectory.end();    }
-inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::end()    		  const { return ftrajectory.end();    }
-inline simb::MCTrajectory::reverse_iterator       simb::MCTrajectory::rbegin() 		        { return ftrajectory.rbegin(); }
-inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rbegin() 		  const { return ftrajectory.rbegin(); }
-inline simb::MCTrajectory::reverse_iterator       simb::MCTrajectory::rend()   		        { return ftrajectory.rend();   }
-inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rend()   		  const { return ftrajectory.rend();   }
-inline simb::MCTrajectory::size_type              simb::MCTrajectory::size()   		  const { return ftrajectory.size();   }
-inline bool                                       simb::MCTrajectory::empty()  		  const { return ftrajectory.empty();  }
-inline void                                       simb::MCTrajectory::clear()                   { ftrajectory.clear();         }
-inline void                                       simb::MCTrajectory::swap(simb::MCTrajectory& other) 
-{ ftrajectory.swap( other.ftrajectory ); }
-
-inline const simb::MCTrajectory::value_type&      simb::MCTrajectory::operator[](const simb::MCTrajectory::size_type i) const 
-{ return ftrajectory[i];}
-
-inline const simb::MCTrajectory::value_type&      simb::MCTrajectory::at(const simb::MCTrajectory::size_type i)         const 
-{ return ftrajectory.at(i); }
+inline double                 simb::MCTrajectory::X ( const size_type i ) const { return fx[i];                }
+inline double 		      simb::MCTrajectory::Y ( const size_type i ) const { return fy[i];                }
+inline double 		      simb::MCTrajectory::Z ( const size_type i ) const { return fz[i];                }
+inline double 		      simb::MCTrajectory::T ( const size_type i ) const { return ft[i];                }
+inline double 		      simb::MCTrajectory::Px( const size_type i ) const { return fpx[i];               }
+inline double 		      simb::MCTrajectory::Py( const size_type i ) const { return fpy[i];               }
+inline double 		      simb::MCTrajectory::Pz( const size_type i ) const { return fpz[i];               }
+inline double 		      simb::MCTrajectory::E ( const size_type i ) const { return fe[i];                }
+
+inline TLorentzVector         simb::MCTrajectory::Position( const size_type i ) const 
+{ return TLorentzVector(fx[i], fy[i], fz[i], ft[i]); }
+
+inline TLorentzVector         simb::MCTrajectory::Momentum( const size_type i ) const 
+{ return TLorentzVector(fpx[i], fpy[i], fpz[i], fe[i]); }
+
+inline simb::MCTrajectory::iterator               simb::MCTrajectory::begin()                   { return iterator(this, 0);                 }
+inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::begin()  		  const { return const_iterator(this, 0);           }
+inline simb::MCTrajectory::iterator               simb::MCTrajectory::end()    		        { return iterator(this, size());            }
+inline simb::MCTrajectory::const_iterator         simb::MCTrajectory::end()    		  const { return const_iterator(this, size());      }
+inline simb::MCTrajectory::reverse_iterator       simb::MCTrajectory::rbegin() 		        { return reverse_iterator(end());           }
+inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rbegin() 		  const { return const_reverse_iterator(end());     }
+inline simb::MCTrajectory::reverse_iterator       simb::MCTrajectory::rend()   		        { return reverse_iterator(begin());         }
+inline simb::MCTrajectory::const_reverse_iterator simb::MCTrajectory::rend()   		  const { return const_reverse_iterator(begin());   }
+inline simb::MCTrajectory::size_type              simb::MCTrajectory::size()   		  const { return fx.size();                   }
+inline bool                                       simb::MCTrajectory::empty()  		  const { return fx.empty();                  }
+inline bool                                       simb::MCTrajectory::IsPacked()		  const { return !fpacked.empty();            }
+
+inline simb::MCTrajectory::value_type             simb::MCTrajectory::operator[](const simb::MCTrajectory::size_type i) const 
+{ return value_type(Position(i), Momentum(i)); }
 
 inline void                                       simb::MCTrajectory::push_back(const simb::MCTrajectory::value_type& v )     
-{ ftrajectory.push_back(v); }
+{ push_back(v.first, v.second); }
 
 inline void                                       simb::MCTrajectory::push_back(const TLorentzVector& p, 
 										const TLorentzVector& m ) 
-{ ftrajectory.push_back( simb::MCTrajectory::value_type(p,m) ); }
+{ ClearDropped(); Append(p, m); }
 
 inline void                                       simb::MCTrajectory::Add(const TLorentzVector& p, 
 									  const TLorentzVector& m )       
@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTrajectoryCodec.cxx
+/// \brief Compact encoding of MCTrajectory points for writing to file
+////////////////////////////////////////////////////////////////////////
+
+#include "SimulationBase/MCTrajectoryCodec.h"
+#include "SimulationBase/MCParticle.h"
+
+#include "cetlib/exception.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+  // how a component was encoded, the first byte of its encoding
+  const unsigned char kLossless  = 0;
+  const unsigned char kQuantized = 1;
+
+  // quantized values must stay well inside a long long so that the
+  // differences between them do too
+  const double kMaxQuantum = 4.e18;
+
+  unsigned long long DoubleBits(double v)
+  {
+    unsigned long long b;
+    std::memcpy(&b, &v, sizeof(b));
+    return b;
+  }
+
+  double BitsDouble(unsigned long long b)
+  {
+    double v;
+    std::memcpy(&v, &b, sizeof(v));
+    return v;
+  }
+
+  void PutFixed(unsigned long long v, std::vector<unsigned char>& out)
+  {
+    for(int i = 0; i < 8; ++i) out.push_back((unsigned char)(v >> (8*i)));
+  }
+
+  unsigned long long GetFixed(std::vector<unsigned char> const& in, size_t& pos)
+  {
+    if(pos + 8 > in.size())
+      throw cet::exception("MCTrajectoryCodec") << "packed trajectory is truncated";
+
+    unsigned long long v = 0;
+    for(int i = 0; i < 8; ++i) v |= (unsigned long long)in[pos++] << (8*i);
+    return v;
+  }
+
+}
+
+namespace simb {
+
+  //......................................................................
+  MCTrajectoryCodec::MCTrajectoryCodec()
+  {
+    for(int c = 0; c < 8; ++c) fPrecision[c] = 0.;
+  }
+
+  //......................................................................
+  MCTrajectoryCodec::MCTrajectoryCodec(double positionPrecision,
+				       double timePrecision,
+				       double momentumPrecision)
+  {
+    if(positionPrecision < 0. || timePrecision < 0. || momentumPrecision < 0.)
+      throw cet::exception("MCTrajectoryCodec") << "precisions must not be negative";
+
+    fPrecision[0] = fPrecision[1] = fPrecision[2] = positionPrecision;
+    fPrecision[3] = timePrecision;
+    fPrecision[4] = fPrecision[5] = fPrecision[6] = fPrecision[7] = momentumPrecision;
+  }
+
+  //......................................................................
+  bool MCTrajectoryCodec::IsLossless() const
+  {
+    for(int c = 0; c < 8; ++c)
+      if(fPrecision[c] > 0.) return false;
+
+    return true;
+  }
+
+  //......................................................................
+  void MCTrajectoryCodec::PutVarint(unsigned long long v, std::vector<unsigned char>& out)
+  {
+    while(v >= 0x80){
+      out.push_back((unsigned char)(v | 0x80));
+      v >>= 7;
+    }
+    out.push_back((unsigned char)v);
+  }
+
+  //......................................................................
+  unsigned long long MCTrajectoryCodec::GetVarint(std::vector<unsigned char> const& in, size_t& pos)
+  {
+    unsigned long long v = 0;
+    for(int shift = 0; shift < 64; shift += 7){
+      if(pos >= in.size())
+	throw cet::exception("MCTrajectoryCodec") << "packed trajectory is truncated";
+      const unsigned char b = in[pos++];
+      v |= (unsigned long long)(b & 0x7f) << shift;
+      if( !(b & 0x80) ) return v;
+    }
+
+    throw cet::exception("MCTrajectoryCodec") << "bad variable length integer in packed trajectory";
+  }
+
+  //......................................................................
+  void MCTrajectoryCodec::Encode(std::vector<double> const&  values,
+				 int                         component,
+				 std::vector<unsigned char>& out) const
+  {
+    const double precision = fPrecision[component];
+    const size_t n         = values.size();
+
+    bool quantize = precision > 0.;
+    for(size_t i = 0; quantize && i < n; ++i)
+      quantize = std::isfinite(values[i]) && std::abs(values[i]/precision) < kMaxQuantum;
+
+    if( !quantize ){
+      out.push_back(kLossless);
+      unsigned long long prev = 0;
+      for(size_t i = 0; i < n; ++i){
+	const unsigned long long bits = DoubleBits(values[i]);
+	PutFixed(bits ^ prev, out);
+	prev = bits;
+      }
+      return;
+    }
+
+    out.push_back(kQuantized);
+    PutFixed(DoubleBits(precision), out);
+    long long prev = 0;
+    for(size_t i = 0; i < n; ++i){
+      const long long q = std::llround(values[i]/precision);
+      const long long d = q - prev;
+      // zig-zag, so that small negative differences are small too
+      PutVarint(((unsigned long long)d << 1) ^ (unsigned long long)(d >> 63), out);
+      prev = q;
+    }
+
+    return;
+  }
+
+  //......................................................................
+  void MCTrajectoryCodec::Decode(std::vector<unsigned char> const& in,
+				 size_t&                           pos,
+				 size_t                            n,
+				 std::vector<double>&              values)
+  {
+    if(pos >= in.size())
+      throw cet::exception("MCTrajectoryCodec") << "packed trajectory is truncated";
+
+    const unsigned char mode = in[pos++];
+
+    // every value takes at least one byte, eight if lossless, so a count
+    // the bytes left can't hold is corrupt; don't allocate for it
+    const size_t left = in.size() - pos;
+    if(n > ((mode == kLossless) ? left/8 : left))
+      throw cet::exception("MCTrajectoryCodec") << "packed trajectory is truncated";
+
+    values.resize(n);
+
+    if(mode == kLossless){
+      unsigned long long prev = 0;
+      for(size_t i = 0; i < n; ++i){
+	prev ^= GetFixed(in, pos);
+	values[i] = BitsDouble(prev);
+      }
+    }
+    else if(mode == kQuantized){
+      const double precision = BitsDouble(GetFixed(in, pos));
+      long long q = 0;
+      for(size_t i = 0; i < n; ++i){
+	const unsigned long long z = GetVarint(in, pos);
+	q += (long long)(z >> 1) ^ -(long long)(z & 1);
+	values[i] = q*precision;
+      }
+    }
+    else
+      throw cet::exception("MCTrajectoryCodec") << "unknown encoding " << (int)mode
+						<< " in packed trajectory";
+
+    return;
+  }
+
+  //......................................................................
+  // The job-wide codec.  Kept behind a function so it is set up before
+  // anyone can use it.
+  static MCTrajectoryCodec* DefaultCodec(bool set, MCTrajectoryCodec const* codec)
+  {
+    static MCTrajectoryCodec theCodec;
+    static bool              isSet = false;
+
+    if(set){
+      isSet = (codec != 0);
+      if(codec) theCodec = *codec;
+    }
+
+    return isSet ? &theCodec : 0;
+  }
+
+  //......................................................................
+  MCTrajectoryCodec const* MCTrajectoryCodec::Default()
+  {
+    return DefaultCodec(false, 0);
+  }
+
+  //......................................................................
+  void MCTrajectoryCodec::SetDefault(MCTrajectoryCodec const& codec)
+  {
+    DefaultCodec(true, &codec);
+  }
+
+  //......................................................................
+  void MCTrajectoryCodec::ClearDefault()
+  {
+    DefaultCodec(true, 0);
+  }
+
+  //......................................................................
+  void MCTrajectoryCodec::PackForWriting(std::vector<simb::MCParticle>& particles)
+  {
+    const MCTrajectoryCodec* codec = MCTrajectoryCodec::Default();
+    if( !codec ) return;
+
+    for(size_t i = 0; i < particles.size(); ++i) particles[i].PackTrajectory(*codec);
+  }
+
+} // namespace simb
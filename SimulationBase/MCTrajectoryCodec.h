@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTrajectoryCodec.h
+/// \brief Compact encoding of MCTrajectory points for writing to file
+////////////////////////////////////////////////////////////////////////
+
+/// Trajectories make up most of the volume of a simulation file.
+/// Neighbouring points are close together, so storing the differences
+/// between them takes far fewer bytes than storing each point in full.
+///
+/// Each of the eight components (x,y,z,t,px,py,pz,E) is encoded on its
+/// own, in one of two ways:
+///
+///   - quantized: each value is rounded to a multiple of a fixed
+///     precision (say 10 um in position, 0.1 MeV in momentum) and the
+///     differences between consecutive multiples are written as
+///     variable length integers, usually one or two bytes each.
+///   - lossless: each value is XORed with the one before, which leaves
+///     the sign, exponent and leading mantissa bits zero for nearby
+///     values, and written as eight bytes for ROOT's compression to
+///     squeeze.  Decoding gives back exactly the same doubles.
+///
+/// A component that cannot be quantized (too large for the precision,
+/// or not finite) falls back to lossless.
+///
+/// The codec is chosen per job with SetDefault(), normally by
+/// configuring the MCTrajectoryPacking service.  Nothing is packed
+/// behind anyone's back: the module that makes the particles calls
+/// PackForWriting() on them just before putting them into the event,
+/// and does nothing if no codec was chosen.  Packed trajectories have
+/// no points until unpacked, which reading them back does
+/// automatically, so readers need no configuration.  The precisions
+/// are in whatever units the trajectory is in; with Geant4 that is mm,
+/// ns and GeV.
+
+#ifndef SIMB_MCTRAJECTORYCODEC_H
+#define SIMB_MCTRAJECTORYCODEC_H
+
+#include <vector>
+#include <cstddef>
+
+namespace simb {
+
+  class MCParticle;
+
+  class MCTrajectoryCodec {
+  public:
+
+    /// Lossless encoding of every component.
+    MCTrajectoryCodec();
+
+    /// Quantize positions, times and momenta/energies to the given
+    /// precisions.  A precision of 0 keeps that component lossless.
+    MCTrajectoryCodec(double positionPrecision,
+		      double timePrecision,
+		      double momentumPrecision);
+
+    /// Precision used for component c, in the order x,y,z,t,px,py,pz,E;
+    /// 0 means lossless.
+    double Precision(int c)  const;
+    bool   IsLossless()      const;
+
+    /// Append the encoding of one component to out.
+    void   Encode(std::vector<double> const&  values,
+		  int                         component,
+		  std::vector<unsigned char>& out) const;
+
+    /// Decode n values of one component starting at in[pos] and advance
+    /// pos past them.  Needs no codec settings, as the encoding records
+    /// how it was made.
+    static void Decode(std::vector<unsigned char> const& in,
+		       size_t&                           pos,
+		       size_t                            n,
+		       std::vector<double>&              values);
+
+    /// Helpers for the packed format shared with MCTrajectory.
+    static void     PutVarint(unsigned long long v, std::vector<unsigned char>& out);
+    static unsigned long long GetVarint(std::vector<unsigned char> const& in, size_t& pos);
+
+    /// The codec for this job, 0 if trajectories are not to be packed.
+    static MCTrajectoryCodec const* Default();
+    static void                     SetDefault(MCTrajectoryCodec const& codec);
+    static void                     ClearDefault();
+
+    /// Pack the trajectories of these particles with the job's codec,
+    /// if there is one.  Call it last thing before putting them into
+    /// the event; modules later in the job see the trajectories packed.
+    static void PackForWriting(std::vector<simb::MCParticle>& particles);
+
+  private:
+
+    double fPrecision[8]; ///< per component, 0 for lossless
+  };
+
+} // namespace simb
+
+inline double simb::MCTrajectoryCodec::Precision(int c) const { return fPrecision[c]; }
+
+#endif // SIMB_MCTRAJECTORYCODEC_H
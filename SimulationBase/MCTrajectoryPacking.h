@@ -0,0 +1,54 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTrajectoryPacking.h
+/// \brief Service choosing how this job packs MCTrajectory points on file
+////////////////////////////////////////////////////////////////////////
+
+/// Configuring this service is what turns on the compact encoding of
+/// trajectories described in MCTrajectoryCodec.h; without it they are
+/// written as plain arrays.  It takes three parameters, the precisions
+/// to quantize to in the trajectory's units (mm, ns and GeV with
+/// Geant4):
+///
+///    - "PositionPrecision"
+///    - "TimePrecision"
+///    - "MomentumPrecision"
+///
+/// A precision of 0 keeps that component lossless, so all three at 0
+/// gives back exactly the points that were simulated.  See
+/// mctrajectorypacking.fcl for a standard set.
+///
+/// The service only chooses the codec; the module making the particles
+/// packs them with MCTrajectoryCodec::PackForWriting() before putting
+/// them into the event.  Modules after it in the same job see packed,
+/// empty trajectories and have to unpack a copy to get at the points.
+///
+/// Packing trades the split columns for size.  MCTrajectory keeps no
+/// custom streamer, so it is still split member-wise, but a packed
+/// trajectory is a single byte array: the x, y, ... columns are empty
+/// on file and reading any one component means reading and decoding
+/// them all.  Leave the service out of jobs whose output is analysed
+/// column by column.
+
+#ifndef SIMB_MCTRAJECTORYPACKING_H
+#define SIMB_MCTRAJECTORYPACKING_H
+
+// Framework includes
+#include "fhiclcpp/ParameterSet.h"
+#include "art/Framework/Services/Registry/ActivityRegistry.h"
+#include "art/Framework/Services/Registry/ServiceMacros.h"
+
+namespace simb {
+
+  class MCTrajectoryPacking {
+  public:
+    MCTrajectoryPacking(fhicl::ParameterSet const& pset, art::ActivityRegistry& reg);
+    ~MCTrajectoryPacking();
+
+    void reconfigure(fhicl::ParameterSet const& pset);
+
+  };
+
+}
+
+DECLARE_ART_SERVICE(simb::MCTrajectoryPacking, LEGACY)
+#endif // SIMB_MCTRAJECTORYPACKING_H
@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTrajectoryPacking_service.cc
+/// \brief Service choosing how this job packs MCTrajectory points on file
+////////////////////////////////////////////////////////////////////////
+
+#include "SimulationBase/MCTrajectoryPacking.h"
+#include "SimulationBase/MCTrajectoryCodec.h"
+
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+namespace simb {
+
+  //......................................................................
+  MCTrajectoryPacking::MCTrajectoryPacking(fhicl::ParameterSet const& pset, 
+					   art::ActivityRegistry& /*reg*/)
+  {
+    this->reconfigure(pset);
+  }
+
+  //......................................................................
+  MCTrajectoryPacking::~MCTrajectoryPacking()
+  {
+    simb::MCTrajectoryCodec::ClearDefault();
+  }
+
+  //......................................................................
+  void MCTrajectoryPacking::reconfigure(fhicl::ParameterSet const& pset)
+  {
+    const double position = pset.get< double >("PositionPrecision");
+    const double time     = pset.get< double >("TimePrecision"    );
+    const double momentum = pset.get< double >("MomentumPrecision");
+
+    simb::MCTrajectoryCodec::SetDefault(simb::MCTrajectoryCodec(position, time, momentum));
+
+    LOG_INFO("MCTrajectoryPacking") << "packing trajectories on writing with precisions "
+				    << position << " (position), " 
+				    << time     << " (time), "
+				    << momentum << " (momentum); 0 is lossless";
+
+    return;
+  }
+
+}// namespace simb
+
+namespace simb {
+
+  DEFINE_ART_SERVICE(MCTrajectoryPacking)
+
+} // namespace simb
@@ -14,6 +14,15 @@
 #include "TDatabasePDG.h"
 
 #include <iostream>
+#include <mutex>
+
+namespace {
+
+  // Serializes building the index of any MCTruth; it only happens once
+  // per particle list, so there is no point in a lock per object.
+  std::mutex gIndexMutex;
+
+} // namespace
 
 namespace simb{
 
@@ -23,9 +32,93 @@ namespace simb{
     , fMCNeutrino()
     , fOrigin(simb::kUnknown)
     , fNeutrinoSet(false)
+    , fIndex()
+    , fIndexValid(false)
   { 
   }
 
+  //......................................................................
+  MCTruth::MCTruth(MCTruth const& other)
+    : fPartList(other.fPartList)
+    , fMCNeutrino(other.fMCNeutrino)
+    , fOrigin(other.fOrigin)
+    , fNeutrinoSet(other.fNeutrinoSet)
+    , fIndex()
+    , fIndexValid(false)
+  {
+  }
+
+  //......................................................................
+  MCTruth::MCTruth(MCTruth&& other)
+    : fPartList(std::move(other.fPartList))
+    , fMCNeutrino(std::move(other.fMCNeutrino))
+    , fOrigin(other.fOrigin)
+    , fNeutrinoSet(other.fNeutrinoSet)
+    , fIndex()
+    , fIndexValid(false)
+  {
+    other.fIndexValid.store(false);
+  }
+
+  //......................................................................
+  MCTruth& MCTruth::operator=(MCTruth const& other)
+  {
+    if(this != &other){
+      fPartList    = other.fPartList;
+      fMCNeutrino  = other.fMCNeutrino;
+      fOrigin      = other.fOrigin;
+      fNeutrinoSet = other.fNeutrinoSet;
+      fIndexValid.store(false);
+    }
+
+    return *this;
+  }
+
+  //......................................................................
+  MCTruth& MCTruth::operator=(MCTruth&& other)
+  {
+    if(this != &other){
+      fPartList    = std::move(other.fPartList);
+      fMCNeutrino  = std::move(other.fMCNeutrino);
+      fOrigin      = other.fOrigin;
+      fNeutrinoSet = other.fNeutrinoSet;
+      fIndexValid.store(false);
+      other.fIndexValid.store(false);
+    }
+
+    return *this;
+  }
+
+  //......................................................................
+  const simb::MCTruthIndex& MCTruth::Index() const
+  {
+    // A const MCTruth, e.g. one in an art product, may be shared by
+    // several threads.  The index is built under the lock and then
+    // published with a release store, so once it exists a lookup only
+    // costs an acquire load of the flag.
+    if( !fIndexValid.load(std::memory_order_acquire) ){
+      std::lock_guard<std::mutex> lock(gIndexMutex);
+      if( !fIndexValid.load(std::memory_order_relaxed) ){
+	fIndex.Build(fPartList);
+	fIndexValid.store(true, std::memory_order_release);
+      }
+    }
+
+    return fIndex;
+  }
+
+  //......................................................................
+  bool MCTruth::IsDescendantOf(int trackId, int ancestorTrackId) const
+  {
+    const simb::MCTruthIndex& index = this->Index();
+
+    const int pos         = index.Find(trackId);
+    const int ancestorPos = index.Find(ancestorTrackId);
+    if(pos < 0 || ancestorPos < 0) return false;
+
+    return index.IsDescendantOf(pos, ancestorPos);
+  }
+
   //......................................................................
   void MCTruth::SetNeutrino(int CCNC, 
 			    int mode, 
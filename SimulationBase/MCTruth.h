@@ -9,12 +9,16 @@
 #define SIMB_MCTRUTH_H
 
 #include <vector>
+#include <utility>
+#ifndef __GCCXML__
+#include <atomic>
+#endif
 #include "SimulationBase/MCNeutrino.h"
+#include "SimulationBase/MCParticle.h"
+#include "SimulationBase/MCTruthIndex.h"
 
 namespace simb {
 
-  class MCParticle;
-
   /// event origin types
   typedef enum _ev_origin{
     kUnknown,           ///< ???
@@ -38,16 +42,47 @@ namespace simb {
     simb::Origin_t                fOrigin;      ///< origin for this event
     bool                          fNeutrinoSet; ///< flag for whether the neutrino information has been set
 
+    mutable simb::MCTruthIndex    fIndex;       ///< track ID and ancestry lookup, built on first use; not written out
+#ifndef __GCCXML__
+    mutable std::atomic<bool>     fIndexValid;  ///< whether fIndex describes the current fPartList; not written out
+#else
+    mutable bool                  fIndexValid;  ///< gccxml can't parse <atomic>; same layout, and never streamed
+#endif
+
 #ifndef __GCCXML__
   public:
 
+    // The index isn't copied; a copy builds its own when first asked.
+    MCTruth(MCTruth const& other);
+    MCTruth(MCTruth&& other);
+    MCTruth& operator=(MCTruth const& other);
+    MCTruth& operator=(MCTruth&& other);
+
     simb::Origin_t          Origin()            const;
     int                     NParticles()        const;
     const simb::MCParticle& GetParticle(int i)  const;
     const simb::MCNeutrino& GetNeutrino()       const;
     bool                    NeutrinoSet()       const;
+
+    // Lookups by track ID.  The first call builds an index of the
+    // particle list, which later calls share until the list changes.
+    // They may be made from several threads at once, as long as none
+    // of them changes the particle list meanwhile.
+    const simb::MCTruthIndex& Index()                           const;
+    int                       FindByTrackId(int trackId)        const; ///< position in the particle list, -1 if absent
+    bool                      IsDescendantOf(int trackId, 
+					     int ancestorTrackId) const; ///< false if either is absent
     
     void             Add(simb::MCParticle& part);           
+    void             Add(simb::MCParticle&& part);          ///< take over the particle instead of copying it
+
+    /// Construct a particle in place at the end of the list, passing the
+    /// arguments on to the MCParticle constructor.  Returns the new
+    /// particle so its trajectory points can be added.
+    template <typename... Args>
+    simb::MCParticle& Emplace(Args&&... args);
+
+    void             Reserve(int n);                        ///< make room for n particles in total
     void             SetOrigin(simb::Origin_t origin);
     void             SetNeutrino(int CCNC, 
 				 int mode, 
@@ -73,8 +108,21 @@ inline int                     simb::MCTruth::NParticles()        const { return
 inline const simb::MCParticle& simb::MCTruth::GetParticle(int i)  const { return fPartList[i];          }
 inline const simb::MCNeutrino& simb::MCTruth::GetNeutrino()       const { return fMCNeutrino;           }
 inline bool                    simb::MCTruth::NeutrinoSet()       const { return fNeutrinoSet;          }
-
-inline void                    simb::MCTruth::Add(simb::MCParticle& part)      { fPartList.push_back(part);    }
+inline int                     simb::MCTruth::FindByTrackId(int trackId)    const { return Index().Find(trackId); }
+
+inline void                    simb::MCTruth::Add(simb::MCParticle& part)      { fPartList.push_back(part); 
+                                                                                  fIndexValid.store(false);    }
+inline void                    simb::MCTruth::Add(simb::MCParticle&& part)     { fPartList.push_back(std::move(part)); 
+                                                                                  fIndexValid.store(false);    }
+inline void                    simb::MCTruth::Reserve(int n)                   { fPartList.reserve(n);         }
+
+template <typename... Args>
+inline simb::MCParticle&       simb::MCTruth::Emplace(Args&&... args)
+{
+  fPartList.emplace_back(std::forward<Args>(args)...);
+  fIndexValid.store(false);
+  return fPartList.back();
+}
 inline void                    simb::MCTruth::SetOrigin(simb::Origin_t origin) { fOrigin = origin;             }
 
 #endif
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTruthColumns.cxx
+/// \brief Column-wise copy of the particles in one or more MCTruths
+////////////////////////////////////////////////////////////////////////
+#include "SimulationBase/MCTruthColumns.h"
+#include "SimulationBase/MCTruth.h"
+#include "SimulationBase/MCParticle.h"
+
+namespace simb{
+
+  //......................................................................
+  MCTruthColumns::MCTruthColumns()
+  {
+    fEventBegin.push_back(0);
+  }
+
+  //......................................................................
+  MCTruthColumns::MCTruthColumns(simb::MCTruth const& truth)
+  {
+    fEventBegin.push_back(0);
+    this->Reserve(truth.NParticles());
+    this->Append(truth);
+  }
+
+  //......................................................................
+  void MCTruthColumns::Clear()
+  {
+    fEventBegin.assign(1, 0);
+    fPdg    .clear();
+    fStatus .clear();
+    fMother .clear();
+    fTrackId.clear();
+    fVx     .clear();
+    fVy     .clear();
+    fVz     .clear();
+    fT      .clear();
+    fPx     .clear();
+    fPy     .clear();
+    fPz     .clear();
+    fE      .clear();
+    fEndE   .clear();
+  }
+
+  //......................................................................
+  void MCTruthColumns::Reserve(size_t n)
+  {
+    fPdg    .reserve(n);
+    fStatus .reserve(n);
+    fMother .reserve(n);
+    fTrackId.reserve(n);
+    fVx     .reserve(n);
+    fVy     .reserve(n);
+    fVz     .reserve(n);
+    fT      .reserve(n);
+    fPx     .reserve(n);
+    fPy     .reserve(n);
+    fPz     .reserve(n);
+    fE      .reserve(n);
+    fEndE   .reserve(n);
+  }
+
+  //......................................................................
+  void MCTruthColumns::Append(simb::MCTruth const& truth)
+  {
+    const int n = truth.NParticles();
+    for(int i = 0; i < n; ++i){
+      const simb::MCParticle&   part = truth.GetParticle(i);
+      const simb::MCTrajectory& traj = part.Trajectory();
+
+      fPdg    .push_back(part.PdgCode());
+      fStatus .push_back(part.StatusCode());
+      fMother .push_back(part.Mother());
+      fTrackId.push_back(part.TrackId());
+
+      if( traj.empty() ){
+	fVx.push_back(0.); fVy.push_back(0.); fVz.push_back(0.); fT.push_back(0.);
+	fPx.push_back(0.); fPy.push_back(0.); fPz.push_back(0.); fE.push_back(0.);
+	fEndE.push_back(0.);
+	continue;
+      }
+
+      fVx  .push_back(traj.X(0));
+      fVy  .push_back(traj.Y(0));
+      fVz  .push_back(traj.Z(0));
+      fT   .push_back(traj.T(0));
+      fPx  .push_back(traj.Px(0));
+      fPy  .push_back(traj.Py(0));
+      fPz  .push_back(traj.Pz(0));
+      fE   .push_back(traj.E(0));
+      fEndE.push_back(traj.E(traj.size()-1));
+    }
+
+    fEventBegin.push_back(fPdg.size());
+
+    return;
+  }
+
+} // namespace simb
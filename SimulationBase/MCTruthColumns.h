@@ -0,0 +1,106 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTruthColumns.h
+/// \brief Column-wise copy of the particles in one or more MCTruths
+////////////////////////////////////////////////////////////////////////
+
+/// Selections that look at every particle in an event spend most of
+/// their time going through MCParticle and its trajectory to get at a
+/// handful of numbers.  This class copies those numbers out once into
+/// one array per quantity, so that a selection becomes a plain loop
+/// the compiler can vectorize:
+///
+///     simb::MCTruthColumns cols(truth);
+///     const int*    pdg    = &cols.PdgCode()[0];
+///     const int*    status = &cols.StatusCode()[0];
+///     const double* e      = &cols.E()[0];
+///     int npi = 0;
+///     for(size_t i = 0; i < cols.size(); ++i)
+///       npi += (status[i] == 1 && (pdg[i] == 211 || pdg[i] == -211) && e[i] > 0.1);
+///
+/// Several MCTruths can be appended to the same columns to select over a
+/// whole batch of events at once; EventBegin(i) and EventEnd(i) give the
+/// rows that came from the i-th one.  Row j of an event is particle j of
+/// that MCTruth.
+///
+/// Position and momentum are those of the first trajectory point, EndE
+/// is the energy at the last one.  Particles without trajectory points
+/// get zeros.  The columns are a snapshot: they do not follow later
+/// changes to the MCTruth, and they are not written out.
+
+#ifndef SIMB_MCTRUTHCOLUMNS_H
+#define SIMB_MCTRUTHCOLUMNS_H
+
+#include <vector>
+#include <cstddef>
+
+namespace simb {
+
+  class MCTruth;
+
+  class MCTruthColumns {
+  public:
+    MCTruthColumns();
+    explicit MCTruthColumns(simb::MCTruth const& truth);
+
+    void   Append(simb::MCTruth const& truth); ///< add the particles of another event
+    void   Clear();
+    void   Reserve(size_t n);                  ///< make room for n particles in total
+
+    size_t size()              const;          ///< number of particles, over all events
+    size_t NEvents()           const;
+    size_t EventBegin(size_t i) const;         ///< first row of the i-th event appended
+    size_t EventEnd(size_t i)   const;         ///< one past the last row of the i-th event
+
+    std::vector<int>    const& PdgCode()    const;
+    std::vector<int>    const& StatusCode() const;
+    std::vector<int>    const& Mother()     const;
+    std::vector<int>    const& TrackId()    const;
+    std::vector<double> const& Vx()         const;
+    std::vector<double> const& Vy()         const;
+    std::vector<double> const& Vz()         const;
+    std::vector<double> const& T()          const;
+    std::vector<double> const& Px()         const;
+    std::vector<double> const& Py()         const;
+    std::vector<double> const& Pz()         const;
+    std::vector<double> const& E()          const;
+    std::vector<double> const& EndE()       const;
+
+  private:
+
+    std::vector<size_t> fEventBegin; ///< first row of each event, plus the total at the end
+    std::vector<int>    fPdg;
+    std::vector<int>    fStatus;
+    std::vector<int>    fMother;
+    std::vector<int>    fTrackId;
+    std::vector<double> fVx;
+    std::vector<double> fVy;
+    std::vector<double> fVz;
+    std::vector<double> fT;
+    std::vector<double> fPx;
+    std::vector<double> fPy;
+    std::vector<double> fPz;
+    std::vector<double> fE;
+    std::vector<double> fEndE;
+  };
+
+} // namespace simb
+
+inline size_t                            simb::MCTruthColumns::size()               const { return fPdg.size();           }
+inline size_t                            simb::MCTruthColumns::NEvents()            const { return fEventBegin.size()-1;  }
+inline size_t                            simb::MCTruthColumns::EventBegin(size_t i) const { return fEventBegin[i];        }
+inline size_t                            simb::MCTruthColumns::EventEnd(size_t i)   const { return fEventBegin[i+1];      }
+inline std::vector<int>    const&        simb::MCTruthColumns::PdgCode()            const { return fPdg;                  }
+inline std::vector<int>    const&        simb::MCTruthColumns::StatusCode()         const { return fStatus;               }
+inline std::vector<int>    const&        simb::MCTruthColumns::Mother()             const { return fMother;               }
+inline std::vector<int>    const&        simb::MCTruthColumns::TrackId()            const { return fTrackId;              }
+inline std::vector<double> const&        simb::MCTruthColumns::Vx()                 const { return fVx;                   }
+inline std::vector<double> const&        simb::MCTruthColumns::Vy()                 const { return fVy;                   }
+inline std::vector<double> const&        simb::MCTruthColumns::Vz()                 const { return fVz;                   }
+inline std::vector<double> const&        simb::MCTruthColumns::T()                  const { return fT;                    }
+inline std::vector<double> const&        simb::MCTruthColumns::Px()                 const { return fPx;                   }
+inline std::vector<double> const&        simb::MCTruthColumns::Py()                 const { return fPy;                   }
+inline std::vector<double> const&        simb::MCTruthColumns::Pz()                 const { return fPz;                   }
+inline std::vector<double> const&        simb::MCTruthColumns::E()                  const { return fE;                    }
+inline std::vector<double> const&        simb::MCTruthColumns::EndE()               const { return fEndE;                 }
+
+#endif // SIMB_MCTRUTHCOLUMNS_H
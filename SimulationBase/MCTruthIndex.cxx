@@ -0,0 +1,143 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTruthIndex.cxx
+/// \brief Track ID lookup and ancestry information for an MCTruth
+////////////////////////////////////////////////////////////////////////
+#include "SimulationBase/MCTruthIndex.h"
+#include "SimulationBase/MCParticle.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace simb{
+
+  //......................................................................
+  MCTruthIndex::MCTruthIndex()
+    : fMinTrackId(0)
+  {
+  }
+
+  //......................................................................
+  void MCTruthIndex::Clear()
+  {
+    fMinTrackId = 0;
+    fDense     .clear();
+    fSortedIds .clear();
+    fSortedPos .clear();
+    fParent    .clear();
+    fChildBegin.clear();
+    fChildren  .clear();
+    fEnter     .clear();
+    fExit      .clear();
+    fTour      .clear();
+  }
+
+  //......................................................................
+  int MCTruthIndex::Find(int trackId) const
+  {
+    if( !fDense.empty() ){
+      const int i = trackId - fMinTrackId;
+      if(i < 0 || i >= (int)fDense.size()) return -1;
+      return fDense[i];
+    }
+
+    std::vector<int>::const_iterator itr = std::lower_bound(fSortedIds.begin(), fSortedIds.end(), trackId);
+    if(itr == fSortedIds.end() || *itr != trackId) return -1;
+    return fSortedPos[itr - fSortedIds.begin()];
+  }
+
+  //......................................................................
+  void MCTruthIndex::Build(std::vector<simb::MCParticle> const& particles)
+  {
+    this->Clear();
+
+    const int n = particles.size();
+    if(n == 0){
+      fChildBegin.push_back(0);
+      return;
+    }
+
+    // track ID -> position.  Use a plain table when the IDs are close
+    // enough together, which they are for every generator we have and
+    // for Geant4; fall back to a sorted list otherwise.  If a track ID
+    // appears twice the first particle wins.
+    int minId = particles[0].TrackId();
+    int maxId = minId;
+    for(int p = 1; p < n; ++p){
+      minId = std::min(minId, particles[p].TrackId());
+      maxId = std::max(maxId, particles[p].TrackId());
+    }
+    fMinTrackId = minId;
+
+    const double span = double(maxId) - double(minId) + 1.;
+    if(span <= 4.*n + 64.){
+      fDense.assign((size_t)span, -1);
+      for(int p = n-1; p >= 0; --p) fDense[particles[p].TrackId() - minId] = p;
+    }
+    else{
+      std::vector< std::pair<int, int> > idPos;
+      idPos.reserve(n);
+      for(int p = 0; p < n; ++p) idPos.push_back(std::make_pair(particles[p].TrackId(), p));
+      std::stable_sort(idPos.begin(), idPos.end());
+      for(int p = 0; p < n; ++p){
+	if(p > 0 && idPos[p].first == idPos[p-1].first) continue;
+	fSortedIds.push_back(idPos[p].first);
+	fSortedPos.push_back(idPos[p].second);
+      }
+    }
+
+    // parents, and the children grouped by parent
+    fParent.resize(n);
+    fChildBegin.assign(n+1, 0);
+    for(int p = 0; p < n; ++p){
+      int parent = this->Find(particles[p].Mother());
+      // a particle can't be its own mother
+      if(parent == p) parent = -1;
+      fParent[p] = parent;
+      if(parent >= 0) ++fChildBegin[parent+1];
+    }
+    for(int p = 0; p < n; ++p) fChildBegin[p+1] += fChildBegin[p];
+
+    fChildren.resize(fChildBegin[n]);
+    std::vector<int> fill(fChildBegin.begin(), fChildBegin.end()-1);
+    for(int p = 0; p < n; ++p)
+      if(fParent[p] >= 0) fChildren[fill[fParent[p]]++] = p;
+
+    // Number the particles depth first, starting from each particle
+    // without a mother in the list.  Anything not reached that way is
+    // part of a mother loop, which shouldn't happen; give each such
+    // particle a tree of its own so that everything gets a number.
+    fEnter.assign(n, -1);
+    fExit .assign(n, -1);
+    fTour .reserve(n);
+
+    std::vector< std::pair<int, int> > stack; // (position, next child to visit)
+    for(int pass = 0; pass < 2; ++pass){
+      for(int root = 0; root < n; ++root){
+	if(fEnter[root] >= 0) continue;
+	if(pass == 0 && fParent[root] >= 0) continue;
+
+	fEnter[root] = fTour.size();
+	fTour.push_back(root);
+	stack.push_back(std::make_pair(root, fChildBegin[root]));
+
+	while( !stack.empty() ){
+	  const int p = stack.back().first;
+	  int&      c = stack.back().second;
+	  if(c == fChildBegin[p+1]){
+	    fExit[p] = fTour.size();
+	    stack.pop_back();
+	    continue;
+	  }
+	  const int child = fChildren[c++];
+	  if(fEnter[child] >= 0) continue;
+	  fEnter[child] = fTour.size();
+	  fTour.push_back(child);
+	  stack.push_back(std::make_pair(child, fChildBegin[child]));
+	}
+      }
+    }
+
+    return;
+  }
+
+} // namespace simb
@@ -0,0 +1,95 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  MCTruthIndex.h
+/// \brief Track ID lookup and ancestry information for an MCTruth
+////////////////////////////////////////////////////////////////////////
+
+/// Positions in the MCTruth particle list, keyed by track ID, plus the
+/// mother/daughter tree those particles form.  MCTruth builds one of
+/// these the first time it is asked a question by track ID and keeps
+/// it until the particle list changes, so that
+///
+///   - finding a particle by track ID is a table lookup,
+///   - the children of a particle are a contiguous list,
+///   - the particles are numbered in depth-first order, so that
+///     the descendants of a particle are the ones numbered between
+///     its Enter() and Exit(), and "is a descended from b" is two
+///     comparisons.
+///
+/// Particles whose mother is not in the list (primaries, or mothers
+/// that fell below an energy cut) start trees of their own.
+///
+/// All positions are indices into the MCTruth particle list; -1 means
+/// there is no such particle.
+
+#ifndef SIMB_MCTRUTHINDEX_H
+#define SIMB_MCTRUTHINDEX_H
+
+#include <vector>
+
+namespace simb {
+
+  class MCParticle;
+
+  class MCTruthIndex {
+  public:
+    MCTruthIndex();
+
+  private:
+
+    int              fMinTrackId;  ///< smallest track ID, the offset into fDense
+    std::vector<int> fDense;       ///< position for each track ID from fMinTrackId up, when the IDs are close together
+    std::vector<int> fSortedIds;   ///< track IDs in increasing order, when they are too spread out for fDense
+    std::vector<int> fSortedPos;   ///< position of each track ID in fSortedIds
+    std::vector<int> fParent;      ///< position of the mother of each particle
+    std::vector<int> fChildBegin;  ///< where the children of each particle start in fChildren
+    std::vector<int> fChildren;    ///< positions of the children, grouped by parent
+    std::vector<int> fEnter;       ///< depth-first number of each particle
+    std::vector<int> fExit;        ///< one past the depth-first number of its last descendant
+    std::vector<int> fTour;        ///< positions in depth-first order
+
+#ifndef __GCCXML__
+  public:
+
+    typedef std::vector<int>::const_iterator const_iterator;
+
+    /// Index the given particles
+    void Build(std::vector<simb::MCParticle> const& particles);
+    void Clear();
+
+    int  Find(int trackId)               const; ///< position of the particle with this track ID
+    int  Parent(int pos)                 const; ///< position of the mother, -1 if not in the list
+    bool IsDescendantOf(int pos,
+			int ancestorPos)         const; ///< is pos below ancestorPos (not counting itself)?
+
+    int  NChildren(int pos)              const;
+    int  Child(int pos, int i)           const; ///< position of the i-th child of pos
+
+    int  Enter(int pos)                  const;
+    int  Exit(int pos)                   const;
+
+    /// Positions of a particle and all its descendants, in depth-first
+    /// order; the particle itself comes first.
+    const_iterator SubtreeBegin(int pos) const;
+    const_iterator SubtreeEnd(int pos)   const;
+
+#endif
+  };
+
+} // namespace simb
+
+#ifndef __GCCXML__
+
+inline int  simb::MCTruthIndex::Parent(int pos)                      const { return fParent[pos];                        }
+inline int  simb::MCTruthIndex::NChildren(int pos)                   const { return fChildBegin[pos+1]-fChildBegin[pos]; }
+inline int  simb::MCTruthIndex::Child(int pos, int i)                const { return fChildren[fChildBegin[pos]+i];       }
+inline int  simb::MCTruthIndex::Enter(int pos)                       const { return fEnter[pos];                         }
+inline int  simb::MCTruthIndex::Exit(int pos)                        const { return fExit[pos];                          }
+inline bool simb::MCTruthIndex::IsDescendantOf(int pos, int ancPos)  const
+{ return fEnter[ancPos] < fEnter[pos] && fEnter[pos] < fExit[ancPos]; }
+
+inline simb::MCTruthIndex::const_iterator simb::MCTruthIndex::SubtreeBegin(int pos) const { return fTour.begin()+fEnter[pos]; }
+inline simb::MCTruthIndex::const_iterator simb::MCTruthIndex::SubtreeEnd(int pos)   const { return fTour.begin()+fExit[pos];  }
+
+#endif
+
+#endif // SIMB_MCTRUTHINDEX_H
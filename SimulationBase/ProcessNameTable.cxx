@@ -0,0 +1,250 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ProcessNameTable.cxx
+/// \brief Table of the physics process names used by MCParticle
+////////////////////////////////////////////////////////////////////////
+
+#include "SimulationBase/ProcessNameTable.h"
+
+#include "cetlib/exception.h"
+
+#include <limits>
+#include <mutex>
+
+namespace {
+
+  // Guards every table.  In practice there is only Instance() and the
+  // copies written out or read back, so one lock is plenty.
+  std::mutex gTableMutex;
+
+  // The built-in names.  Only ever add to the end of this list, or the
+  // codes stored in existing files will point at the wrong names.
+  const char* const kBuiltin[] = {
+    "",                   // no process set, e.g. the end process before tracking
+    "primary",
+    "Decay",
+    "muIoni",
+    "eIoni",
+    "hIoni",
+    "ionIoni",
+    "eBrem",
+    "muBrems",
+    "hBrems",
+    "muPairProd",
+    "hPairProd",
+    "annihil",
+    "compt",
+    "phot",
+    "conv",
+    "Rayl",
+    "msc",
+    "CoulombScat",
+    "hadElastic",
+    "protonInelastic",
+    "neutronInelastic",
+    "pi+Inelastic",
+    "pi-Inelastic",
+    "kaon+Inelastic",
+    "kaon-Inelastic",
+    "kaon0LInelastic",
+    "kaon0SInelastic",
+    "lambdaInelastic",
+    "anti_protonInelastic",
+    "anti_neutronInelastic",
+    "dInelastic",
+    "tInelastic",
+    "He3Inelastic",
+    "alphaInelastic",
+    "ionInelastic",
+    "nCapture",
+    "nKiller",
+    "muMinusCaptureAtRest",
+    "hBertiniCaptureAtRest",
+    "CHIPSNuclearCaptureAtRest",
+    "electronNuclear",
+    "positronNuclear",
+    "photonNuclear",
+    "muonNuclear",
+    "Transportation",
+    "CoupledTransportation",
+    "StepLimiter",
+    "OpAbsorption",
+    "OpRayleigh",
+    "OpWLS",
+    "Scintillation",
+    "Cerenkov",
+  };
+  const unsigned int kNBuiltin = sizeof(kBuiltin)/sizeof(kBuiltin[0]);
+
+  // what codes read without an input table become, past the built-in ones
+  const char* const kUnknown = "unknown";
+
+  //......................................................................
+  simb::ProcessNameTable BuiltinTable()
+  {
+    simb::ProcessNameTable table;
+    for(unsigned int i = 0; i < kNBuiltin; ++i)
+      table.Code(kBuiltin[i]);
+
+    return table;
+  }
+
+} // namespace
+
+namespace simb {
+
+  //......................................................................
+  ProcessNameTable::ProcessNameTable()
+    : fNames()
+    , fCodes()
+    , fInputCodes()
+    , fHaveInput(false)
+  {
+  }
+
+  //......................................................................
+  ProcessNameTable::ProcessNameTable(ProcessNameTable const& other)
+    : fNames()
+    , fCodes()
+    , fInputCodes()
+    , fHaveInput(false)
+  {
+    std::lock_guard<std::mutex> lock(gTableMutex);
+    fNames = other.fNames;
+    this->BuildIndex();
+  }
+
+  //......................................................................
+  ProcessNameTable& ProcessNameTable::operator=(ProcessNameTable const& other)
+  {
+    if( this == &other ) return *this;
+
+    std::lock_guard<std::mutex> lock(gTableMutex);
+    fNames = other.fNames;
+    this->BuildIndex();
+
+    return *this;
+  }
+
+  //......................................................................
+  ProcessNameTable& ProcessNameTable::Instance()
+  {
+    // initialized once, even if several threads get here together
+    static ProcessNameTable table(BuiltinTable());
+
+    return table;
+  }
+
+  //......................................................................
+  ProcessNameTable::code_type ProcessNameTable::Code(std::string const& name)
+  {
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    return this->FindOrAdd(name);
+  }
+
+  //......................................................................
+  ProcessNameTable::code_type ProcessNameTable::FindOrAdd(std::string const& name)
+  {
+    // a table read back from a file only has the names
+    if( fCodes.size() != fNames.size() ) this->BuildIndex();
+
+    std::map<std::string, code_type>::const_iterator itr = fCodes.find(name);
+    if( itr != fCodes.end() ) return itr->second;
+
+    if( fNames.size() > std::numeric_limits<code_type>::max() )
+      throw cet::exception("ProcessNameTable") << "too many distinct process names, cannot add "
+					       << name;
+
+    const code_type code = fNames.size();
+    fNames.push_back(name);
+    fCodes[name] = code;
+
+    return code;
+  }
+
+  //......................................................................
+  std::string const& ProcessNameTable::Name(code_type code) const
+  {
+    // the deque never moves the names, so the reference outlives the lock
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    if( code >= fNames.size() )
+      throw cet::exception("ProcessNameTable") << "no process name with code " << code;
+
+    return fNames[code];
+  }
+
+  //......................................................................
+  unsigned int ProcessNameTable::NNames() const
+  {
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    return fNames.size();
+  }
+
+  //......................................................................
+  void ProcessNameTable::aggregate(ProcessNameTable const& other)
+  {
+    if( this == &other ) return;
+
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    for(unsigned int c = 0; c < other.fNames.size(); ++c)
+      this->FindOrAdd(other.fNames[c]);
+
+    return;
+  }
+
+  //......................................................................
+  bool ProcessNameTable::SetInput(ProcessNameTable const& input)
+  {
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    // names new to this table get the next free code, which is the
+    // input's own code as long as the two tables agree so far
+    bool same = true;
+    fInputCodes.resize(input.fNames.size());
+    for(unsigned int c = 0; c < input.fNames.size(); ++c){
+      fInputCodes[c] = this->FindOrAdd(input.fNames[c]);
+      if( fInputCodes[c] != c ) same = false;
+    }
+    fHaveInput = true;
+
+    return same;
+  }
+
+  //......................................................................
+  void ProcessNameTable::ClearInput()
+  {
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    fInputCodes.clear();
+    fHaveInput = false;
+
+    return;
+  }
+
+  //......................................................................
+  ProcessNameTable::code_type ProcessNameTable::FromInput(code_type code)
+  {
+    std::lock_guard<std::mutex> lock(gTableMutex);
+
+    if( fHaveInput ){
+      if( code < fInputCodes.size() ) return fInputCodes[code];
+    }
+    else if( code < kNBuiltin ) return code;
+
+    return this->FindOrAdd(kUnknown);
+  }
+
+  //......................................................................
+  void ProcessNameTable::BuildIndex()
+  {
+    fCodes.clear();
+    for(unsigned int c = 0; c < fNames.size(); ++c)
+      fCodes[fNames[c]] = c;
+
+    return;
+  }
+
+} // namespace simb
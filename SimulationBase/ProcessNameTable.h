@@ -0,0 +1,105 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ProcessNameTable.h
+/// \brief Table of the physics process names used by MCParticle
+////////////////////////////////////////////////////////////////////////
+
+/// Every MCParticle records the process that created it and the one
+/// that ended it.  There are only a few dozen distinct names in a job,
+/// so rather than carry two strings per particle, each particle keeps
+/// a small code into this table and the names are stored once.
+///
+/// The job-wide table is ProcessNameTable::Instance().  It starts out
+/// with the names Geant4 and the generators use most often, always in
+/// the same order, so those codes are the same in every job.  Any other
+/// name gets the next free code the first time it is seen.
+///
+/// Codes beyond the built-in list are handed out in the order a job
+/// first sees the names, so they only mean something together with the
+/// table of the job that assigned them, and two jobs may give the same
+/// code to different names.  The simb::ProcessNameTableMaker producer
+/// deals with that: it writes a copy of Instance() into each run, and at
+/// the start of each run it reads back the tables of the input run and
+/// installs them with SetInput().  The codes of MCParticles read from
+/// then on are translated into Instance()'s codes, by name, as they are
+/// read (FromInput(), called by the I/O rule in classes_def.xml).  When a
+/// job has not assigned codes of its own yet it takes over the input's,
+/// so usually nothing needs translating.  Without an input table only
+/// the built-in codes can be trusted; other codes are read as "unknown".
+///
+/// All access to a table is guarded by a lock, so Instance() can be
+/// used from several threads.
+
+#ifndef SIMB_PROCESSNAMETABLE_H
+#define SIMB_PROCESSNAMETABLE_H
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace simb {
+
+  class ProcessNameTable {
+  public:
+
+    typedef unsigned short code_type;
+
+    /// An empty table; use Instance() for the job-wide one.
+    ProcessNameTable();
+
+    /// Copies are taken under the lock, e.g. to write Instance() out.
+    ProcessNameTable(ProcessNameTable const& other);
+    ProcessNameTable& operator=(ProcessNameTable const& other);
+
+  private:
+
+    std::deque<std::string>          fNames;      ///< process names, indexed by code
+    std::map<std::string, code_type> fCodes;      ///< code for each name, rebuilt on read; not written out
+    std::vector<code_type>           fInputCodes; ///< code here for each code of the input; not written out
+    bool                             fHaveInput;  ///< whether SetInput() was given a table; not written out
+
+#ifndef __GCCXML__
+  public:
+
+    /// The table shared by every MCParticle in the job.
+    static ProcessNameTable& Instance();
+
+    /// Code for a process name, adding the name to the table if this is
+    /// the first time it has been seen.
+    code_type          Code(std::string const& name);
+
+    /// The name for a code.  The reference stays valid for the life of
+    /// the table.
+    std::string const& Name(code_type code) const;
+
+    unsigned int       NNames()            const;
+
+    /// Combine the table of the same run from another input file (art
+    /// calls this): names this table does not have yet are added.  A code
+    /// the other table gives to a different name keeps its meaning here.
+    void               aggregate(ProcessNameTable const& other);
+
+    /// Codes of MCParticles read from now on are those of input: make
+    /// FromInput() translate them, adding to this table the names it does
+    /// not have yet.  Returns true if the codes mean the same in both
+    /// tables, so that nothing needs translating.
+    bool               SetInput(ProcessNameTable const& input);
+
+    /// No input table: FromInput() keeps the built-in codes only.
+    void               ClearInput();
+
+    /// The code in this table for a code read from the input.
+    code_type          FromInput(code_type code);
+
+  private:
+
+    // the work of Code() and BuildIndex(), for callers holding the lock
+    code_type          FindOrAdd(std::string const& name);
+    void               BuildIndex();
+
+#endif
+  };
+
+} // namespace simb
+
+#endif // SIMB_PROCESSNAMETABLE_H
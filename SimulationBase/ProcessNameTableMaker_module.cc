@@ -0,0 +1,127 @@
+////////////////////////////////////////////////////////////////////////
+/// \file  ProcessNameTableMaker_module.cc
+/// \brief Write the job's process name table with each run, and merge
+///        the tables of the runs read in
+////////////////////////////////////////////////////////////////////////
+
+/// MCParticles keep their process names as codes into
+/// simb::ProcessNameTable::Instance().  Codes past the built-in names
+/// are handed out as names are first seen, so they are only good
+/// together with the table of the job that assigned them.  This module
+/// keeps the two together:
+///
+///  - at the start of each run it combines every simb::ProcessNameTable
+///    found in the input run and installs it as the input table of
+///    Instance(), before any event of the run, and so any MCParticle of
+///    the run, is read; the codes of those particles are translated
+///    into this job's as they are read
+///  - at the end of each run it puts a copy of Instance() into the run
+///
+/// Put it in a path of every job that writes or reads MCParticles; it
+/// takes no parameters (see processnametable.fcl).
+///
+/// Particles copied to the output without being read again (art's fast
+/// cloning) keep the input's codes.  That is only right if this job
+/// did not have to translate them; if it did, a warning says so, and
+/// fast cloning should be turned off in the output module.
+
+#include <memory>
+#include <vector>
+
+// Framework includes
+#include "art/Framework/Core/EDProducer.h"
+#include "art/Framework/Core/ModuleMacros.h"
+#include "art/Framework/Principal/Event.h"
+#include "art/Framework/Principal/Run.h"
+#include "art/Framework/Principal/Handle.h"
+#include "fhiclcpp/ParameterSet.h"
+#include "messagefacility/MessageLogger/MessageLogger.h"
+
+#include "SimulationBase/ProcessNameTable.h"
+
+namespace simb {
+
+  class ProcessNameTableMaker : public art::EDProducer {
+
+  public:
+
+    explicit ProcessNameTableMaker(fhicl::ParameterSet const& pset);
+    virtual ~ProcessNameTableMaker();
+
+    void produce(art::Event& evt);
+    void beginRun(art::Run& run);
+    void endRun(art::Run& run);
+
+  };
+
+  //......................................................................
+  ProcessNameTableMaker::ProcessNameTableMaker(fhicl::ParameterSet const& /*pset*/)
+  {
+    produces< simb::ProcessNameTable, art::InRun >();
+  }
+
+  //......................................................................
+  ProcessNameTableMaker::~ProcessNameTableMaker()
+  {
+  }
+
+  //......................................................................
+  void ProcessNameTableMaker::produce(art::Event& /*evt*/)
+  {
+    // everything happens at run boundaries
+  }
+
+  //......................................................................
+  void ProcessNameTableMaker::beginRun(art::Run& run)
+  {
+    std::vector< art::Handle<simb::ProcessNameTable> > tables;
+    run.getManyByType(tables);
+
+    // the tables of the jobs the run went through (or of its input
+    // files); a later job takes over the codes of earlier ones, so these
+    // normally agree
+    simb::ProcessNameTable input;
+    size_t ntables = 0;
+    for(size_t i = 0; i < tables.size(); ++i){
+      if( !tables[i].isValid() ) continue;
+      input.aggregate(*tables[i]);
+      ++ntables;
+    }
+
+    simb::ProcessNameTable& table = simb::ProcessNameTable::Instance();
+    if( ntables == 0 ){
+      table.ClearInput();
+      LOG_DEBUG("ProcessNameTableMaker") << "no process name table in run " << run.run()
+					 << "; only the built-in process codes are kept";
+    }
+    else if( !table.SetInput(input) ){
+      mf::LogWarning("ProcessNameTableMaker") << "process codes in run " << run.run()
+					      << " differ from this job's and are translated"
+					      << " as MCParticles are read; turn off fast"
+					      << " cloning in the output module";
+    }
+
+    LOG_DEBUG("ProcessNameTableMaker") << "read " << ntables
+				       << " process name tables from run "
+				       << run.run() << ", " << table.NNames()
+				       << " names known";
+
+    return;
+  }
+
+  //......................................................................
+  void ProcessNameTableMaker::endRun(art::Run& run)
+  {
+    std::unique_ptr<simb::ProcessNameTable> copy(new simb::ProcessNameTable(simb::ProcessNameTable::Instance()));
+    run.put(std::move(copy));
+
+    return;
+  }
+
+} // namespace simb
+
+namespace simb {
+
+  DEFINE_ART_MODULE(ProcessNameTableMaker)
+
+} // namespace simb
@@ -26,6 +26,7 @@
 #include "SimulationBase/MCNeutrino.h"
 #include "SimulationBase/MCFlux.h"
 #include "SimulationBase/GTruth.h"
+#include "SimulationBase/ProcessNameTable.h"
 #include <TLorentzVector.h>
 //
 // Only include objects that we would like to be able to put into the event.
@@ -60,6 +61,7 @@ template class art::Wrapper< std::vector<simb::MCParticle> >;
 template class art::Wrapper< std::vector<simb::MCTruth> >;
 template class art::Wrapper< std::vector<simb::MCFlux> >;
 template class art::Wrapper< std::vector<simb::GTruth> >;
+template class art::Wrapper< simb::ProcessNameTable >;
 
 template class art::Wrapper< art::Assns<simb::MCParticle, simb::MCTruth,    void> >;
 template class art::Wrapper< art::Assns<simb::MCTruth,    simb::MCParticle, void> >;
@@ -16,6 +16,7 @@
 //#define __GENIE_LOW_LEVEL_MESG_ENABLED__
 
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 #include <vector>
 #include <sstream>
@@ -31,6 +32,10 @@
 #include <TChainElement.h>
 #include <TSystem.h>
 #include <TStopwatch.h>
+#include <TRandom3.h>
+#include <TThread.h>
+#include <TMutex.h>
+#include <TCondition.h>
 
 // GENIE headers
 #include "Conventions/GBuild.h"
@@ -51,8 +56,10 @@
 #include "tree/dkmeta.h"
 #include "tree/NuChoice.h"
 #include "tree/calcLocationWeights.h"
+#include "tree/AncChains.h"
 
 #include <vector>
+#include <deque>
 #include <algorithm>
 #include <iomanip>
 #include "TRegexp.h"
@@ -95,6 +102,158 @@ namespace genie {
       TRotation   fBeamRotXML;
       TVector3    fFluxWindowPtXML[3];
     };
+
+    // reads dk2nu entries ahead of use on a thread of its own, through
+    // its own chain; Next() hands them out in order
+    class GDk2NuFluxPrefetch {
+    public:
+      GDk2NuFluxPrefetch(TChain* chain, Long64_t first, Long64_t end,
+                         int depth, const std::vector<bool>* usable);
+      ~GDk2NuFluxPrefetch();
+
+      /// entry ientry (previous one is given back); entries in cache are
+      /// not read ahead, as they won't be asked for
+      bsim::Dk2Nu* Next(Long64_t ientry, const GDk2NuFluxDecayCache* cache);
+
+    private:
+      typedef std::pair<Long64_t,bsim::Dk2Nu*> Record;
+
+      static void* ThreadFunc(void* arg);
+      void         ReadLoop();
+      Long64_t     After(Long64_t ientry) const;
+      Long64_t     NextToRead(Long64_t ientry,
+                              const GDk2NuFluxDecayCache* cache) const;
+
+      TChain*                    fChain;      ///< owned, read on fThread only
+      Long64_t                   fFirstEntry; ///< range of entries taken
+      Long64_t                   fEndEntry;
+      int                        fDepth;      ///< # of entries to read ahead
+      const std::vector<bool>*   fUsable;     ///< entries to read (0 = all)
+      bsim::Dk2Nu*               fReadDk2Nu;  ///< where fChain reads entries to
+
+      // used by the caller's thread only
+      std::deque<Long64_t>       fAhead;      ///< entries asked for and not handed out, in order
+      Long64_t                   fLastAsked;  ///< last entry put in fAhead
+
+      // guarded by fMutex
+      std::vector<bsim::Dk2Nu*>  fFree;       ///< records free to be filled
+      std::deque<Long64_t>       fToRead;     ///< entries still to be read, in order
+      std::deque<Record>         fReady;      ///< filled records, in the order read
+      bsim::Dk2Nu*               fInUse;      ///< record last handed out
+      bool                       fStop;
+
+      TMutex                     fMutex;
+      TCondition                 fCond;
+      TThread*                   fThread;
+    };
+
+    // the max weight scan spread over threads: the tries are cut into
+    // fixed size chunks, each with its own range of entries and its own
+    // random number seed, and the threads take chunks until none are left
+    class GDk2NuFluxWgtScan {
+    public:
+      GDk2NuFluxWgtScan() : fUsable(0), fNextChunk(0), fWgtMax(0), fEnuMax(0) { ; }
+
+      void Run(const std::vector<TChain*>& chains,
+               double& wgtmax, double& enumax);
+
+      // the flux window and what to scan, filled in by GDk2NuFlux
+      TLorentzVector  fBase;
+      TLorentzVector  fDir1;
+      TLorentzVector  fDir2;
+      TVector3        fNormal;
+      bool            fApplyTilt;
+      PDGCodeList     fPdgCList;
+      long int        fNUse;       ///< tries per entry
+      long int        fNTries;     ///< tries in all
+      Long64_t        fNEntries;
+      UInt_t          fSeedBase;
+      const std::vector<bool>* fUsable;  ///< entries worth reading (0 = all)
+
+    private:
+      struct Worker {
+        GDk2NuFluxWgtScan* scan;
+        TChain*            chain;
+      };
+
+      static void* ThreadFunc(void* arg);
+      void         Scan(TChain* chain);
+
+      TMutex          fMutex;      ///< guards the members below
+      long int        fNextChunk;
+      double          fWgtMax;
+      double          fEnuMax;
+    };
+
+    // summary of each flux file, kept in a text file so that later jobs
+    // can set up the chains without opening every file
+    class GDk2NuFluxCatalog {
+    public:
+      struct Entry {
+        Long64_t          size;
+        Long_t            mtime;
+        std::string       treenames[2];
+        Long64_t          nentries;
+        double            pots;
+        std::vector<int>  jobs;       ///< job of each metadata entry
+      };
+
+      GDk2NuFluxCatalog() : fChanged(false) { ; }
+
+      void Read(const std::string& fname);
+      void Write(const std::string& fname);
+      bool Changed() const { return fChanged; }
+
+      /// summary of a file if there is one that is still good
+      bool Find(const std::string& path, const std::string treenames[2],
+                Entry& entry) const;
+      /// summarize a file from its trees and add it to the catalog
+      void Add(const std::string& path, const std::string treenames[2],
+               TTree* ftree, TTree* mtree, Entry& entry);
+
+    private:
+      std::map<std::string,Entry>  fEntries;
+      bool                         fChanged;
+    };
+
+    // what GenerateNext_weighted() uses of each entry, packed in memory
+    // as entries are first read; the muon parent details needed for the
+    // polarization weight are kept on the side, for muon decays only
+    class GDk2NuFluxDecayCache {
+    public:
+      GDk2NuFluxDecayCache(Long64_t first, Long64_t end, double maxbytes);
+
+      bool Get(Long64_t ientry, bsim::Dk2Nu& dk2nu, double& t_dk) const;
+      void Put(Long64_t ientry, const bsim::Dk2Nu& dk2nu, double t_dk);
+      bool Has(Long64_t ientry) const
+        { return fRecs[ientry-fFirstEntry].imu != -2; }
+
+      static double BytesPerEntry() { return sizeof(Rec); }
+      Long64_t NCached() const { return fNCached; }
+      double   NBytes() const
+        { return fRecs.size()*sizeof(Rec) + fMuRecs.size()*sizeof(MuRec); }
+
+    private:
+      struct Rec {
+        Double_t vx, vy, vz;
+        Double_t pdpx, pdpy, pdpz;
+        Double_t necm, nimpwt;
+        Double_t tdk;
+        Int_t    ptype, ntype;
+        Int_t    job, potnum;
+        Int_t    imu;       ///< index in fMuRecs (-1 = none, -2 = not cached)
+      };
+      struct MuRec {
+        Double_t ppdxdz, ppdydz, pppz, ppenergy;
+        Double_t muparpx, muparpy, muparpz, mupare;
+      };
+
+      Long64_t            fFirstEntry;
+      std::vector<Rec>    fRecs;      ///< one per entry from fFirstEntry on
+      std::vector<MuRec>  fMuRecs;
+      double              fMaxBytes;
+      Long64_t            fNCached;
+    };
   }
 }
 
@@ -128,7 +287,6 @@ bool GDk2NuFlux::GenerateNext(void)
 {
 // Get next (unweighted) flux ntuple entry on the specified detector location
 //
-  RandomGen* rnd = RandomGen::Instance();
   while ( true ) {
      // Check for end of flux ntuple
      bool end = this->End();
@@ -155,18 +313,29 @@ bool GDk2NuFlux::GenerateNext(void)
      */
 
      // Get fractional weight & decide whether to accept curr flux neutrino
-     double f = this->Weight() / fMaxWeight;
+     // (entries picked by weight are measured against their own bound)
+     double wgtmax = ( fPickByWeight ) ? fPickWgtMax[fIEntry] : fMaxWeight;
+     double f = this->Weight() / wgtmax;
      //LOG("Flux", pNOTICE)
      //   << "Curr flux neutrino fractional weight = " << f;
-     if (f > 1.) {
+     if (f > 1. && fPickByWeight) {
+       // nothing to bump, the bound itself is wrong
+       this->LoadFullDk2Nu();
+       LOG("Flux", pERROR)
+         << "** Fractional weight = " << f 
+         << " > 1 !! for entry " << fIEntry << " picked by weight bound "
+         << wgtmax << fCurDk2Nu->AsString() << "\n" << fCurNuChoice->AsString();
+       std::cout << std::flush;
+     } else if (f > 1.) {
        fMaxWeight = this->Weight() * fMaxWgtFudge; // bump the weight
+       this->LoadFullDk2Nu();
        LOG("Flux", pERROR)
          << "** Fractional weight = " << f 
          << " > 1 !! Bump fMaxWeight estimate to " << fMaxWeight
          << fCurDk2Nu->AsString() << "\n" << fCurNuChoice->AsString();
        std::cout << std::flush;
      }
-     double r = (f < 1.) ? rnd->RndFlux().Rndm() : 0;
+     double r = (f < 1.) ? this->FluxRndm(2) : 0;
      bool accept = ( r < f );
      if ( accept ) {
 
@@ -190,9 +359,10 @@ bool GDk2NuFlux::GenerateNext(void)
   return false;
 }
 //___________________________________________________________________________
-bool GDk2NuFlux::GenerateNext_weighted(void)
+bool GDk2NuFlux::GenerateNextEntry(void)
 {
-// Get next (weighted) flux ntuple entry on the specified detector location
+// Move on to the entry for the next try (or reuse the current one) and
+// account for it; false if there is none or its flavor isn't wanted
 //
 
   // Check whether a flux ntuple has been loaded
@@ -202,35 +372,105 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
      return false;	
   }
 
+  // the pick table is dropped when the flavors, window or files change;
+  // rebuild it before anything reads it, and take a fresh entry rather
+  // than reuse one whose bound came from the old table
+  bool rebuilt = false;
+  if ( fPickByWeight && fPickWgtMax.empty() ) {
+    this->BuildPickTable();
+    rebuilt = true;
+  }
+  // weighted generation takes the entries in order
+  bool pick = ( fPickByWeight && ! fGenWeighted );
+
   // Reuse an entry?
   //std::cout << " ***** iuse " << fIUse << " nuse " << fNUse
   //          << " ientry " << fIEntry << " nentry " << fNEntries
   //          << " icycle " << fICycle << " ncycle " << fNCycles << std::endl;
-  if ( fIUse < fNUse && fIEntry >= 0 ) {
+  if ( fIUse < fNUse && fIEntry >= 0 && ! rebuilt ) {
     // Reuse this entry
     fIUse++;
   } else {
     // Reset previously generated neutrino code / 4-p / 4-x
     this->ResetCurrent();
-    // Move on, read next flux ntuple entry
-    fIEntry++;
-    if ( fIEntry >= fNEntries ) {
-      // Ran out of entries @ the current cycle of this flux file
-      // Check whether more (or infinite) number of cycles is requested
-      if (fICycle < fNCycles || fNCycles == 0 ) {
-        fICycle++;
-        fIEntry=0;
-      } else {
-        LOG("Flux", pWARN)
-          << "No more entries in input flux neutrino ntuple, cycle "
-          << fICycle << " of " << fNCycles;
-        fEnd = true;
-        //assert(0);
-        return false;	
+    if ( pick && fPickWgtMean <= 0 ) {
+      LOG("Flux", pERROR)
+        << "No entries in the flux ntuple can reach the flux window with a "
+        << "flavor in the list " << *fPdgCList;
+      fEnd = true;
+      return false;
+    }
+    if ( ! fEntryUsable.empty() && fNEntryUsable == 0 ) {
+      LOG("Flux", pERROR)
+        << "No entries in the flux ntuple have a flavor in the list "
+        << *fPdgCList;
+      fEnd = true;
+      return false;
+    }
+    while ( true ) {
+      if ( pick ) {
+        // pick an entry by weight bound, a "cycle" being fNEntries picks
+        fIEntry = this->PickEntry();
+        if ( ++fNPicked > fNEntries ) {
+          if (fICycle < fNCycles || fNCycles == 0 ) {
+            fICycle++;
+            fNPicked = 1;
+          } else {
+            LOG("Flux", pWARN)
+              << "No more picks from input flux neutrino ntuple, cycle "
+              << fICycle << " of " << fNCycles;
+            fEnd = true;
+            return false;
+          }
+        }
+        break;
+      }
+      // Move on, read next flux ntuple entry
+      fIEntry++;
+      if ( fIEntry >= fEndEntry ) {
+        // Ran out of entries @ the current cycle of this flux file
+        // Check whether more (or infinite) number of cycles is requested
+        if (fICycle < fNCycles || fNCycles == 0 ) {
+          fICycle++;
+          fIEntry=fFirstEntry;
+        } else {
+          LOG("Flux", pWARN)
+            << "No more entries in input flux neutrino ntuple, cycle "
+            << fICycle << " of " << fNCycles;
+          fEnd = true;
+          //assert(0);
+          return false;	
+        }
       }
+      if ( fEntryUsable.empty() || fEntryUsable[fIEntry] ) break;
+      // the index says this flavor would be rejected; skip reading it,
+      // but account for it as if it had been read and rejected fNUse times
+      fAccumPOTs  += fNUse * ( fEffPOTsPerNu / fMaxWeight );
+      fNNeutrinos += fNUse;
     }
     
-    fNuFluxTree->GetEntry(fIEntry);
+    if ( fDecayCache && fDecayCache->Get(fIEntry,*fChainDk2Nu,fCurTdk) ) {
+      // seen before; the rest of the entry is read if it is asked for
+      fCurDk2Nu     = fChainDk2Nu;
+      fCurDk2NuFull = false;
+    } else {
+      if ( fPrefetchDepth > 0 && ! pick ) {
+        if ( ! fPrefetch ) this->StartPrefetch();
+        fCurDk2Nu = fPrefetch->Next(fIEntry,fDecayCache);
+      } else {
+        this->StopPrefetch();  // in case picking took over from it
+        fNuFluxTree->GetEntry(fIEntry);
+      }
+      fCurDk2NuFull = ! fReadDecayOnly;
+      this->RestoreAncestors(fCurDk2Nu);
+
+      size_t inu = fCurDk2Nu->indxnu();
+      fCurTdk = 0;
+      if ( ! fCurDk2Nu->overflow() && ! fCurDk2Nu->ancestor.empty() ) {
+        fCurTdk = fCurDk2Nu->ancestor[inu].startt; // units?  seconds, hopefully
+      }
+      if ( fDecayCache ) fDecayCache->Put(fIEntry,*fCurDk2Nu,fCurTdk);
+    }
 
 #ifdef __GENIE_LOW_LEVEL_MESG_ENABLED__
   LOG("Flux",pDEBUG) 
@@ -250,7 +490,10 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
   // in order to keep the POT accounting correct.  This allows one to get
   // the right normalization for generating only events from the intrinsic
   // nu_e entries.
-  fAccumPOTs += fEffPOTsPerNu / fMaxWeight;
+  // Picking by weight, every try is worth the mean of the entries' bounds
+  // (in place of the overall maximum) as entries are accepted against
+  // their own bound.
+  fAccumPOTs += fEffPOTsPerNu / ( ( pick ) ? fPickWgtMean : fMaxWeight );
   fNNeutrinos++;
 
   // Check neutrino pdg against declared list of neutrino species declared
@@ -275,6 +518,26 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
      return false;	
   }
 
+  if ( fCurTdk == 0 ) {
+    // probably wasn't set
+    if ( fNTdkZeroMsg > 0 ) {
+      --fNTdkZeroMsg;
+      LOG("Flux", pNOTICE)
+        << "Setting time at flux window, \n"
+        << "noticed that t_dk from ancestor list was 0, "
+        << "this probably means that the calculated time is wrong";
+    }
+  }
+
+  return true;
+}
+//___________________________________________________________________________
+bool GDk2NuFlux::GenerateNext_weighted(void)
+{
+// Get next (weighted) flux ntuple entry on the specified detector location
+//
+  if ( ! this->GenerateNextEntry() ) return false;
+
   // Update the curr neutrino weight and energy
 
   // Check current neutrino energy against the maximum flux neutrino energy 
@@ -290,9 +553,8 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
   double Ev = 0;
   double& wgt_xy = fCurNuChoice->xyWgt;
   // recalculate on x-y window
-  RandomGen * rnd = RandomGen::Instance();
-  fCurNuChoice->x4NuBeam += ( rnd->RndFlux().Rndm()*fFluxWindowDir1 +
-                              rnd->RndFlux().Rndm()*fFluxWindowDir2   );
+  fCurNuChoice->x4NuBeam += ( this->FluxRndm(0)*fFluxWindowDir1 +
+                              this->FluxRndm(1)*fFluxWindowDir2   );
   bsim::calcEnuWgt(fCurDk2Nu->decay,fCurNuChoice->x4NuBeam.Vect(),Ev,wgt_xy);
 
   if (Ev > fMaxEv) {
@@ -325,27 +587,12 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
 
   // set the time component of the Lorentz vectors
   double dist_dk2start = GetDecayDist();
-  size_t inu = fCurDk2Nu->indxnu();
-  double t_dk = 0;
-  if ( ! fCurDk2Nu->overflow() && ! fCurDk2Nu->ancestor.empty() ) {
-    t_dk = fCurDk2Nu->ancestor[inu].startt; // units?  seconds, hopefully
-  }
+  double t_dk = fCurTdk;
   const double c_mbys  = 299792458;
   const double c_cmbys = c_mbys * 100.;
   double tstart = t_dk + ( dist_dk2start / c_cmbys );
   fCurNuChoice->x4NuBeam.SetT(tstart);
   fCurNuChoice->x4NuUser.SetT(tstart);
-  if ( t_dk == 0 ) {
-    // probably wasn't set
-    static int nmsg = 5;
-    if ( nmsg > 0 ) {
-      --nmsg;
-      LOG("Flux", pNOTICE)
-        << "Setting time at flux window, \n"
-        << "noticed that t_dk from ancestor list was 0, "
-        << "this probably means that the calculated time is wrong";
-    }
-  }
 
   // if desired, move to user specified user coord z
   if ( TMath::Abs(fZ0) < 1.0e30 ) this->MoveToZ0(fZ0);
@@ -372,6 +619,319 @@ bool GDk2NuFlux::GenerateNext_weighted(void)
   return true;
 }
 //___________________________________________________________________________
+long int GDk2NuFlux::GenerateNextBatch(long int n)
+{
+// Generate up to n flux neutrinos at once into GetBatch(): the entries,
+// reuse, random numbers and acceptance are those of n GenerateNext()
+// calls, but each ray's direction, coordinate transforms, tilt weight,
+// time and move to fZ0 are done as loops over the arrays of the batch
+//
+  GDk2NuFluxBatch& b = *fBatch;
+  b.Resize(n > 0 ? n : 0);
+  if ( n <= 0 ) return 0;
+  if ( ! fNuFluxTree ) {
+     LOG("Flux", pERROR)
+          << "The flux driver has not been properly configured";
+     return 0;
+  }
+
+  // what each try needs from its entry, by position in the batch
+  std::vector<double> dkx(n), dky(n), dkz(n), tdk(n);
+  std::vector<double> impwgt(n), xywgt(n), enu(n);
+  // and room for the steps of the arithmetic
+  std::vector<double> dist(n), invd(n), dirx(n), diry(n), dirz(n);
+  std::vector<double> cosn(n), tstart(n);
+
+  const bool accepting = ! fGenWeighted;
+  long int   nbad      = 0;   // rays that couldn't be moved to fZ0
+
+  // the tries, in order.  Unweighted, each try's weight and acceptance
+  // are settled before the next one, so random numbers are drawn (and the
+  // max weight bumped) just as GenerateNext() does; a rejected try's
+  // place is taken by the next one
+  size_t nray     = 0;       // rays made
+  bool   rejected = false;   // the last try, in place nray, was rejected
+  double lastwgt  = 0;       // and had this weight
+  while ( (long int)nray < n && ! this->End() ) {
+    if ( ! this->GenerateNextEntry() ) continue;
+    const size_t i = nray;
+
+    // a point on the flux window, and E_nu and weight there
+    TLorentzVector x4 = fFluxWindowBase;
+    x4 += ( this->FluxRndm(0)*fFluxWindowDir1 +
+            this->FluxRndm(1)*fFluxWindowDir2   );
+    double Ev = 0;
+    bsim::calcEnuWgt(fCurDk2Nu->decay,x4.Vect(),Ev,xywgt[i]);
+    if ( Ev > fMaxEv ) {
+      LOG("Flux", pFATAL)
+        << "Generated neutrino had E_nu = " << Ev << " > " << fMaxEv
+        << " maximum ";
+      assert(0);
+    }
+    b.pdgNu[i]       = fCurNuChoice->pdgNu;
+    b.entry[i]       = fIEntry;
+    b.x4NuBeam[0][i] = x4.X();
+    b.x4NuBeam[1][i] = x4.Y();
+    b.x4NuBeam[2][i] = x4.Z();
+    b.x4NuBeam[3][i] = x4.T();
+    dkx[i]    = fCurDk2Nu->decay.vx;
+    dky[i]    = fCurDk2Nu->decay.vy;
+    dkz[i]    = fCurDk2Nu->decay.vz;
+    tdk[i]    = fCurTdk;
+    impwgt[i] = fCurNuChoice->impWgt;
+    enu[i]    = Ev;
+    rejected  = false;
+
+    if ( accepting ) {
+      // the weight, as the loops below would have it
+      double w = impwgt[i] * xywgt[i];
+      if ( fApplyTiltWeight ) {
+        double dx = x4.X() - dkx[i], dy = x4.Y() - dky[i], dz = x4.Z() - dkz[i];
+        double d  = TMath::Sqrt(dx*dx + dy*dy + dz*dz);
+        double iv = 1.0 / ( d + ( ( d > 0 ) ? 0. : 1. ) );
+        double ux = dx * iv, uy = dy * iv, uz = dz * iv;
+        double cs;
+        if ( fIsSphere ) {
+          double sx = x4.X() - fFluxSphereCenterBeam.X();
+          double sy = x4.Y() - fFluxSphereCenterBeam.Y();
+          double sz = x4.Z() - fFluxSphereCenterBeam.Z();
+          double r  = TMath::Sqrt(sx*sx + sy*sy + sz*sz);
+          double ir = 1.0 / ( r + ( ( r > 0 ) ? 0. : 1. ) );
+          cs = ux*(sx*ir) + uy*(sy*ir) + uz*(sz*ir);
+        } else {
+          cs = ux*fFluxWindowNormal.X() + uy*fFluxWindowNormal.Y() +
+               uz*fFluxWindowNormal.Z();
+        }
+        w *= TMath::Abs(cs);
+      }
+      fSumWeight += w;
+
+      double wgtmax = ( fPickByWeight ) ? fPickWgtMax[fIEntry] : fMaxWeight;
+      double f = w / wgtmax;
+      if ( f > 1. && ! fPickByWeight ) {
+        fMaxWeight = w * fMaxWgtFudge; // bump the weight
+      }
+      if ( f > 1. ) {
+        LOG("Flux", pERROR)
+          << "** Fractional weight = " << f << " > 1 !! for entry "
+          << fIEntry << " in a batch; max weight now " << fMaxWeight;
+      }
+      double r = (f < 1.) ? this->FluxRndm(2) : 0;
+      if ( ! ( r < f ) ) {
+        rejected = true;
+        lastwgt  = w;
+        continue;
+      }
+    }
+    ++nray;
+  }
+
+  // the rest, as in GenerateNext_weighted(), over the arrays: short
+  // loops of plain arithmetic on a few arrays each (no branches, few
+  // pointers to check for overlap) that the compiler can vectorize
+  const int m = nray + ( rejected ? 1 : 0 );  // and a rejected last try
+  double* xb  = &b.x4NuBeam[0][0];
+  double* yb  = &b.x4NuBeam[1][0];
+  double* zb  = &b.x4NuBeam[2][0];
+  double* tb  = &b.x4NuBeam[3][0];
+  double* pxb = &b.p4NuBeam[0][0];
+  double* pyb = &b.p4NuBeam[1][0];
+  double* pzb = &b.p4NuBeam[2][0];
+  double* eb  = &b.p4NuBeam[3][0];
+  double* xu  = &b.x4NuUser[0][0];
+  double* yu  = &b.x4NuUser[1][0];
+  double* zu  = &b.x4NuUser[2][0];
+  double* tu  = &b.x4NuUser[3][0];
+  double* pxu = &b.p4NuUser[0][0];
+  double* pyu = &b.p4NuUser[1][0];
+  double* pzu = &b.p4NuUser[2][0];
+  double* eu  = &b.p4NuUser[3][0];
+  double* wgt = &b.wgt[0];
+  const double* vx = &dkx[0];
+  const double* vy = &dky[0];
+  const double* vz = &dkz[0];
+  const double* ev = &enu[0];
+  double* d  = &dist[0];
+  double* iv = &invd[0];
+  double* ux = &dirx[0];
+  double* uy = &diry[0];
+  double* uz = &dirz[0];
+  double* cs = &cosn[0];
+  double* ts = &tstart[0];
+  int i;
+
+  // direction from the decay, as TVector3::Unit(), and the momentum
+  for (i = 0; i < m; ++i) {
+    double dx = xb[i] - vx[i], dy = yb[i] - vy[i], dz = zb[i] - vz[i];
+    d[i] = dx*dx + dy*dy + dz*dz;
+  }
+  for (i = 0; i < m; ++i) d[i] = TMath::Sqrt(d[i]);
+  for (i = 0; i < m; ++i) iv[i] = 1.0 / ( d[i] + ( ( d[i] > 0 ) ? 0. : 1. ) );
+  for (i = 0; i < m; ++i) ux[i] = ( xb[i] - vx[i] ) * iv[i];
+  for (i = 0; i < m; ++i) uy[i] = ( yb[i] - vy[i] ) * iv[i];
+  for (i = 0; i < m; ++i) uz[i] = ( zb[i] - vz[i] ) * iv[i];
+  for (i = 0; i < m; ++i) pxb[i] = ev[i] * ux[i];
+  for (i = 0; i < m; ++i) pyb[i] = ev[i] * uy[i];
+  for (i = 0; i < m; ++i) pzb[i] = ev[i] * uz[i];
+  for (i = 0; i < m; ++i) eb[i]  = ev[i];
+
+  // weight, with the window tilt relative to the flux direction
+  // (unweighted, the tries' weights were needed right away, above)
+  for (i = 0; i < m; ++i) wgt[i] = impwgt[i] * xywgt[i];
+  if ( fApplyTiltWeight && ! accepting ) {
+    if ( fIsSphere ) {
+      // the normal of the sphere at the point, as SphereNormal()
+      const double cx = fFluxSphereCenterBeam.X();
+      const double cy = fFluxSphereCenterBeam.Y();
+      const double cz = fFluxSphereCenterBeam.Z();
+      for (i = 0; i < m; ++i) {
+        double sx = xb[i] - cx, sy = yb[i] - cy, sz = zb[i] - cz;
+        cs[i] = sx*sx + sy*sy + sz*sz;
+      }
+      for (i = 0; i < m; ++i) cs[i] = TMath::Sqrt(cs[i]);
+      for (i = 0; i < m; ++i) cs[i] = 1.0 / ( cs[i] + ( ( cs[i] > 0 ) ? 0. : 1. ) );
+      for (i = 0; i < m; ++i) {
+        double sx = ( xb[i] - cx ) * cs[i];
+        double sy = ( yb[i] - cy ) * cs[i];
+        double sz = ( zb[i] - cz ) * cs[i];
+        cs[i] = ux[i]*sx + uy[i]*sy + uz[i]*sz;
+      }
+    } else {
+      const double nx = fFluxWindowNormal.X();
+      const double ny = fFluxWindowNormal.Y();
+      const double nz = fFluxWindowNormal.Z();
+      for (i = 0; i < m; ++i) cs[i] = ux[i]*nx + uy[i]*ny + uz[i]*nz;
+    }
+    for (i = 0; i < m; ++i) wgt[i] *= TMath::Abs(cs[i]);
+  }
+
+  // time at the window
+  const double c_mbys  = 299792458;
+  const double c_cmbys = c_mbys * 100.;
+  const double b2u     = fLengthScaleB2U;
+  for (i = 0; i < m; ++i) ts[i] = tdk[i] + ( d[i] * b2u / c_cmbys );
+
+  // to user coords, as Beam2UserP4() and Beam2UserPos()
+  double r[4][4];
+  for (int j = 0; j < 4; ++j)
+    for (int k = 0; k < 4; ++k) r[j][k] = fBeamRot(j,k);
+  const double rxx = r[0][0], rxy = r[0][1], rxz = r[0][2], rxt = r[0][3];
+  const double ryx = r[1][0], ryy = r[1][1], ryz = r[1][2], ryt = r[1][3];
+  const double rzx = r[2][0], rzy = r[2][1], rzz = r[2][2], rzt = r[2][3];
+  const double rtx = r[3][0], rty = r[3][1], rtz = r[3][2], rtt = r[3][3];
+  const double x0 = fBeamZero.X(), y0 = fBeamZero.Y(), z0 = fBeamZero.Z();
+  for (i = 0; i < m; ++i)
+    pxu[i] = rxx*pxb[i] + rxy*pyb[i] + rxz*pzb[i] + rxt*eb[i];
+  for (i = 0; i < m; ++i)
+    pyu[i] = ryx*pxb[i] + ryy*pyb[i] + ryz*pzb[i] + ryt*eb[i];
+  for (i = 0; i < m; ++i)
+    pzu[i] = rzx*pxb[i] + rzy*pyb[i] + rzz*pzb[i] + rzt*eb[i];
+  for (i = 0; i < m; ++i)
+    eu[i]  = rtx*pxb[i] + rty*pyb[i] + rtz*pzb[i] + rtt*eb[i];
+  for (i = 0; i < m; ++i)
+    xu[i] = b2u*(rxx*xb[i] + rxy*yb[i] + rxz*zb[i] + rxt*tb[i]) + x0;
+  for (i = 0; i < m; ++i)
+    yu[i] = b2u*(ryx*xb[i] + ryy*yb[i] + ryz*zb[i] + ryt*tb[i]) + y0;
+  for (i = 0; i < m; ++i)
+    zu[i] = b2u*(rzx*xb[i] + rzy*yb[i] + rzz*zb[i] + rzt*tb[i]) + z0;
+  for (i = 0; i < m; ++i) tb[i] = ts[i];
+  for (i = 0; i < m; ++i) tu[i] = ts[i];
+
+  // if desired, move to user specified user coord z, as MoveToZ0();
+  // those that can't be moved are left where they are
+  if ( TMath::Abs(fZ0) < 1.0e30 ) {
+    const double z0usr = fZ0;
+    const double u2b   = fLengthScaleU2B;
+    double* scale = iv;   // no longer needed
+    for (i = 0; i < m; ++i) {
+      double stuck = ( TMath::Abs(pzu[i]) < 1.0e-30 ) ? 1. : 0.;
+      scale[i] = ( 1. - stuck ) * ( z0usr - zu[i] ) / ( pzu[i] + stuck );
+    }
+    for (i = 0; i < m; ++i) xu[i] += scale[i]*pxu[i];
+    for (i = 0; i < m; ++i) yu[i] += scale[i]*pyu[i];
+    for (i = 0; i < m; ++i) zu[i] += scale[i]*pzu[i];
+    for (i = 0; i < m; ++i) xb[i] += (u2b*scale[i])*pxb[i];
+    for (i = 0; i < m; ++i) yb[i] += (u2b*scale[i])*pyb[i];
+    for (i = 0; i < m; ++i) zb[i] += (u2b*scale[i])*pzb[i];
+    // this scaling works for distances, but not the time component
+    for (i = 0; i < m; ++i) {
+      double t = tu[i];
+      tu[i] = ( TMath::Abs(pzu[i]) < 1.0e-30 ) ? t : 0.;
+    }
+    for (i = 0; i < m; ++i) {
+      double t = tb[i];
+      tb[i] = ( TMath::Abs(pzu[i]) < 1.0e-30 ) ? t : 0.;
+    }
+    for (i = 0; i < m; ++i) {
+      if ( TMath::Abs(pzu[i]) < 1.0e-30 ) ++nbad;
+    }
+  }
+
+  b.n = nray;
+  if ( accepting ) {
+    for (size_t k = 0; k < b.n; ++k) b.wgt[k] = 1.;
+  } else {
+    for (size_t k = 0; k < b.n; ++k) fSumWeight += b.wgt[k];
+  }
+
+  // the last try is the current neutrino, as after GenerateNext()
+  if ( m > 0 ) {
+    size_t i = m - 1;
+    fCurNuChoice->xyWgt = xywgt[i];
+    fCurNuChoice->p4NuBeam.SetPxPyPzE(b.p4NuBeam[0][i],b.p4NuBeam[1][i],
+                                      b.p4NuBeam[2][i],b.p4NuBeam[3][i]);
+    fCurNuChoice->x4NuBeam.SetXYZT(b.x4NuBeam[0][i],b.x4NuBeam[1][i],
+                                   b.x4NuBeam[2][i],b.x4NuBeam[3][i]);
+    fCurNuChoice->p4NuUser.SetPxPyPzE(b.p4NuUser[0][i],b.p4NuUser[1][i],
+                                      b.p4NuUser[2][i],b.p4NuUser[3][i]);
+    fCurNuChoice->x4NuUser.SetXYZT(b.x4NuUser[0][i],b.x4NuUser[1][i],
+                                   b.x4NuUser[2][i],b.x4NuUser[3][i]);
+    fgX4dkvtx = TLorentzVector(dkx[i],dky[i],dkz[i],0.);
+    fWeight   = ( rejected ) ? lastwgt : b.wgt[i];
+  }
+
+  if ( nbad > 0 ) {
+    LOG("Flux", pWARN)
+      << "MoveToZ0(" << fZ0 << ") not possible for " << nbad
+      << " neutrinos of the batch due to pz_usr ~ 0";
+  }
+  return b.n;
+}
+//___________________________________________________________________________
+// counter based random numbers: a hash of the counters (splitmix64's
+// mixing function applied to each in turn), so that any one of them can
+// be had without generating those that come before it
+static ULong64_t MixBits(ULong64_t x)
+{
+  const ULong64_t kGamma = ( (ULong64_t)0x9e3779b9 << 32 ) | 0x7f4a7c15;
+  const ULong64_t kMult1 = ( (ULong64_t)0xbf58476d << 32 ) | 0x1ce4e5b9;
+  const ULong64_t kMult2 = ( (ULong64_t)0x94d049bb << 32 ) | 0x133111eb;
+  x += kGamma;
+  x = ( x ^ ( x >> 30 ) ) * kMult1;
+  x = ( x ^ ( x >> 27 ) ) * kMult2;
+  return x ^ ( x >> 31 );
+}
+
+static double CounterRndm(UInt_t seed, Long64_t icycle, Long64_t ientry,
+                          Long64_t iuse, int idraw)
+{
+  ULong64_t x = MixBits(seed);
+  x = MixBits( x ^ (ULong64_t)icycle );
+  x = MixBits( x ^ (ULong64_t)ientry );
+  x = MixBits( x ^ (ULong64_t)iuse );
+  x = MixBits( x ^ (ULong64_t)idraw );
+  // top 53 bits, in (0,1) as TRandom3 gives
+  return ( (double)( x >> 11 ) + 0.5 ) / 9007199254740992.;
+}
+
+double GDk2NuFlux::FluxRndm(int idraw)
+{
+  // the idraw-th random number for the current try: from RandomGen, or
+  // for a CloneForThread() copy a function of (seed, cycle, entry, use)
+  if ( ! fCounterRng ) return RandomGen::Instance()->RndFlux().Rndm();
+  return CounterRndm(fRngSeed,fICycle,fIEntry,fIUse,idraw);
+}
+//___________________________________________________________________________
 double GDk2NuFlux::GetDecayDist() const
 {
   // return distance (user units) between dk point and start position
@@ -486,6 +1046,198 @@ void GDk2NuFlux::LoadDkMeta(void)
     
 }
 
+//___________________________________________________________________________
+void GDk2NuFlux::SetReadProfile(string profile)
+{
+  // set which branches of the dk2nu entries get read (see header)
+
+  std::vector<std::string> words = genie::utils::str::Split(profile," ,;");
+  std::vector<std::string> kept;
+  for (size_t i = 0; i < words.size(); ++i) {
+    std::string word = utils::str::TrimSpaces(words[i]);
+    if ( word != "" ) kept.push_back(word);
+  }
+
+  if ( kept.empty() ) kept.push_back("full");
+  if ( kept[0] != "full" && kept[0] != "decay" ) {
+    LOG("Flux", pWARN)
+      << "SetReadProfile: unknown read profile \"" << kept[0]
+      << "\", reading full entries";
+    kept[0] = "full";
+  }
+
+  fReadProfile = kept[0];
+  for (size_t i = 1; i < kept.size(); ++i) fReadProfile += " " + kept[i];
+  fReadDecayOnly = ( kept[0] == "decay" );
+
+  LOG("Flux", pINFO) << "Read profile for dk2nu entries: " << fReadProfile;
+
+  this->ApplyReadProfile(fNuFluxTree);
+  this->StopPrefetch();  // restarts with the new profile
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::ApplyReadProfile(TChain* chain) const
+{
+  // enable/disable the dk2nu branches according to the read profile
+
+  if ( ! chain ) return;  // done again once the chain exists
+
+  if ( ! fReadDecayOnly ) {
+    chain->SetBranchStatus("*",1);
+    return;
+  }
+
+  // only what GenerateNext_weighted() and LoadDkMeta() use;
+  // the ancestor vector keeps its length, but only startt is filled
+  chain->SetBranchStatus("*",0);
+  chain->SetBranchStatus("dk2nu",1);
+  chain->SetBranchStatus("job",1);
+  chain->SetBranchStatus("potnum",1);
+  chain->SetBranchStatus("decay*",1);
+  chain->SetBranchStatus("flagbits",1);
+  chain->SetBranchStatus("ancestor",1);
+  chain->SetBranchStatus("ancestor.startt",1);
+  chain->SetBranchStatus("ancchain",1);
+  chain->SetBranchStatus("ancleaf",1);
+  chain->SetBranchStatus("anclen",1);
+
+  std::vector<std::string> words = genie::utils::str::Split(fReadProfile," ");
+  for (size_t i = 1; i < words.size(); ++i) {
+    if ( words[i] == "" ) continue;
+    chain->SetBranchStatus(words[i].c_str(),1);
+  }
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::LoadFullDk2Nu(void)
+{
+  // with a "decay" read profile only part of the current entry was read;
+  // read the rest of it the first time it is asked for
+
+  if ( fCurDk2NuFull || ! fNuFluxTree || fIEntry < 0 ) return;
+
+  fNuFluxTree->SetBranchStatus("*",1);
+  fNuFluxTree->GetEntry(fIEntry);
+  this->ApplyReadProfile(fNuFluxTree);
+  fCurDk2Nu     = fChainDk2Nu;  // might have been a read-ahead record
+  fCurDk2NuFull = true;
+  this->RestoreAncestors(fCurDk2Nu);
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::RestoreAncestors(bsim::Dk2Nu* dk2nu)
+{
+  // files written with shared ancestor chains (see tree/AncChains.h) have
+  // entries without an ancestor vector; put it back from their dkancTree
+
+  if ( dk2nu->ancchain < 0 || ! dk2nu->ancestor.empty() ) return;
+
+  if ( ! fAncReader ) {
+    fNuAncTree = new TChain("dkancTree");
+    std::vector<std::string> flist = GetFileList();
+    for (size_t i = 0; i < flist.size(); ++i)
+      fNuAncTree->Add(flist[i].c_str());
+    fAncReader = new bsim::AncChainReader(fNuAncTree);
+  }
+
+  // which file fIEntry is in
+  const Long64_t* offset = fNuFluxTree->GetTreeOffset();
+  int ntrees = fNuFluxTree->GetNtrees();
+  int itree  = std::upper_bound(offset,offset+ntrees,fIEntry) - offset - 1;
+
+  if ( ! fAncReader->Restore(*dk2nu,itree) ) {
+    LOG("Flux", pWARN) << "no shared ancestor chain for entry " << fIEntry
+                       << " (job " << dk2nu->job << " pot# " << dk2nu->potnum
+                       << ")";
+  }
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::SetPrefetchDepth(int depth)
+{
+  fPrefetchDepth = TMath::Max(0,depth);
+  this->StopPrefetch();  // (re)started when the next entry is needed
+
+  LOG("Flux", pINFO) << "Read ahead depth for dk2nu entries: " << fPrefetchDepth;
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::StartPrefetch(void)
+{
+  // give the background reader a chain of its own over the same files
+
+  TChain* chain = new TChain(fTreeNames[0].c_str());
+  std::vector<std::string> flist = GetFileList();
+  for (size_t i = 0; i < flist.size(); ++i) chain->AddFile(flist[i].c_str());
+  this->ApplyReadProfile(chain);
+
+  LOG("Flux", pNOTICE) << "Start reading dk2nu entries " << fPrefetchDepth
+                       << " ahead in a background thread";
+
+  // the reader skips what the index says can't be used, as we do
+  const std::vector<bool>* usable = 0;
+  if ( ! fEntryUsable.empty() ) usable = &fEntryUsable;
+
+  fPrefetch = new GDk2NuFluxPrefetch(chain,fFirstEntry,fEndEntry,
+                                     fPrefetchDepth,usable);
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::StopPrefetch(void)
+{
+  if ( ! fPrefetch ) return;
+
+  // the current entry lives in the reader's buffers, keep a copy
+  if ( fCurDk2Nu != fChainDk2Nu ) {
+    *fChainDk2Nu = *fCurDk2Nu;
+    fCurDk2Nu    = fChainDk2Nu;
+  }
+  delete fPrefetch;
+  fPrefetch = 0;
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::SetDecayCacheSize(double maxmb)
+{
+  fDecayCacheMB = TMath::Max(0.,maxmb);
+  this->StopDecayCache();
+  if ( fNuFluxTree && fNEntries > 0 ) this->StartDecayCache();
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::StartDecayCache(void)
+{
+  if ( fDecayCacheMB <= 0 || fDecayCache ) return;
+
+  double   maxbytes = fDecayCacheMB * 1024. * 1024.;
+  Long64_t nentries = fEndEntry - fFirstEntry;
+  double   needed   = nentries * GDk2NuFluxDecayCache::BytesPerEntry();
+  if ( needed > maxbytes ) {
+    LOG("Flux", pNOTICE)
+      << "Keeping " << nentries << " dk2nu entries in memory needs "
+      << needed/(1024.*1024.) << " MB, over the " << fDecayCacheMB
+      << " MB allowed; reading them from file";
+    return;
+  }
+
+  LOG("Flux", pNOTICE) << "Keeping dk2nu entries in memory as they are read"
+                       << " (up to " << fDecayCacheMB << " MB)";
+  fDecayCache = new GDk2NuFluxDecayCache(fFirstEntry,fEndEntry,maxbytes);
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::StopDecayCache(void)
+{
+  if ( ! fDecayCache ) return;
+
+  LOG("Flux", pINFO) << "Dropping " << fDecayCache->NCached()
+                     << " dk2nu entries kept in memory ("
+                     << fDecayCache->NBytes()/(1024.*1024.) << " MB)";
+  delete fDecayCache;
+  fDecayCache = 0;
+}
+
 //___________________________________________________________________________
 double GDk2NuFlux::UsedPOTs(void) const
 {
@@ -583,6 +1335,12 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
     } // legal directory
   } // loop over patterns
 
+  GDk2NuFluxCatalog catalog;
+  TString catname = fFileCatalog.c_str();
+  gSystem->ExpandPathName(catname);
+  if ( fFileCatalog != "" ) catalog.Read(catname.Data());
+  size_t ncataloged = 0;
+
   size_t indx = 0;
   std::set<string>::const_iterator sitr = fnames.begin();
   for ( ; sitr != fnames.end(); ++sitr, ++indx ) {
@@ -590,13 +1348,22 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
     //std::cout << "  [" << std::setw(3) << indx << "]  \"" 
     //          << filename << "\"" << std::endl;
     bool isok = ! (gSystem->AccessPathName(filename.c_str()));
-    if ( isok ) {
+    GDk2NuFluxCatalog::Entry centry;
+    if ( isok && catalog.Find(filename,fTreeNames,centry) ) {
+      // no need to open it now
+      this->AddFile(filename,centry.nentries,centry.pots,centry.jobs);
+      ++ncataloged;
+    } else if ( isok ) {
       TFile tf(filename.c_str());
       TTree* ftree = (TTree*)tf.Get(fTreeNames[0].c_str());
       TTree* mtree = (TTree*)tf.Get(fTreeNames[1].c_str());
       if ( ftree && mtree ) {
         // found both trees
-        this->AddFile(ftree,mtree,filename);
+        catalog.Add(filename,fTreeNames,ftree,mtree,centry);
+        // don't need these anymore
+        delete ftree;
+        delete mtree;
+        this->AddFile(filename,centry.nentries,centry.pots,centry.jobs);
       } else {
         LOG("Flux", pNOTICE) << "File " << filename << " lacked a tree: "
                              << " \"" << fTreeNames[0] << "\" " << ftree 
@@ -607,8 +1374,17 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
     } // loop over tree type
   } // loop over sorted file names
 
-  // this will open all files and read header!!
-  fNEntries = fNuFluxTree->GetEntries();
+  if ( fFileCatalog != "" ) {
+    LOG("Flux", pNOTICE) << ncataloged << " of " << fnames.size()
+                         << " files were found in catalog " << fFileCatalog;
+    if ( catalog.Changed() ) catalog.Write(catname.Data());
+  }
+
+  // every file was added with its number of entries, so this doesn't
+  // need to open them
+  fNEntries = ( fNuFluxTree ) ? fNuFluxTree->GetEntries() : 0;
+  fFirstEntry = 0;
+  fEndEntry   = fNEntries;
 
   if ( fNEntries == 0 ) {
     LOG("Flux", pERROR)
@@ -636,11 +1412,21 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
     }
   }
 
+  // which entries are worth reading
+  if ( fEntryIndexDir != "" && fNEntries > 0 ) this->LoadEntryIndex();
+
+  // keep entries in memory after first use?
+  if ( fNEntries > 0 ) this->StartDecayCache();
+
   // we have a file we can work with
   if (!fDetLocIsSet) {
      LOG("Flux", pERROR)
        << "LoadBeamSimData left detector location unset";
   }
+  if ( fPickByWeight && fNEntries > 0 ) {
+     // the weight bounds stand in for the scan
+     this->BuildPickTable();
+  }
   if (fMaxWeight<=0) {
      LOG("Flux", pINFO)
        << "Run ScanForMaxWeight() as part of LoadBeamSimData";
@@ -654,6 +1440,7 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
   RandomGen* rnd = RandomGen::Instance();
   fIUse   =  9999999;
   fIEntry = rnd->RndFlux().Integer(fNEntries) - 1;
+  fNPicked = 0;
   
   // don't count things we used to estimate max weight
   fSumWeight  = 0;
@@ -665,6 +1452,126 @@ void GDk2NuFlux::LoadBeamSimData(std::vector<string> patterns, string config )
   
 }
 //___________________________________________________________________________
+GDk2NuFlux* GDk2NuFlux::CloneForThread(int ithread, int nthreads, UInt_t seed)
+{
+  if ( ! fNuFluxTree || nthreads < 1 || ithread < 0 || ithread >= nthreads ) {
+    LOG("Flux", pERROR) << "CloneForThread(" << ithread << "," << nthreads
+                        << ") needs a loaded driver and 0 <= ithread < nthreads";
+    return 0;
+  }
+  if ( fMaxWeight <= 0 ) {
+    // clones share this one's max weight; they can't scan for it
+    // themselves, as each would scan different entries
+    LOG("Flux", pNOTICE) << "CloneForThread: scanning for the max weight first";
+    this->ScanForMaxWeight();
+    if ( fMaxWeight <= 0 ) {
+      LOG("Flux", pERROR) << "CloneForThread needs the max weight, "
+                          << "which ScanForMaxWeight() didn't find";
+      return 0;
+    }
+  }
+
+  // clones read files on threads of their own
+  TThread::Initialize();
+
+  GDk2NuFlux* clone = new GDk2NuFlux;
+
+  // configuration, shared by value
+  clone->fMaxEv           = fMaxEv;
+  clone->fPdgCList->Copy(*fPdgCList);
+  clone->fXMLbasename     = fXMLbasename;
+  clone->fNuFluxFilePatterns = fNuFluxFilePatterns;
+  clone->fTreeNames[0]    = fTreeNames[0];
+  clone->fTreeNames[1]    = fTreeNames[1];
+  clone->fReadProfile     = fReadProfile;
+  clone->fReadDecayOnly   = fReadDecayOnly;
+  clone->fPrefetchDepth   = fPrefetchDepth;
+  clone->fDecayCacheMB    = fDecayCacheMB;
+  clone->fFileCatalog     = fFileCatalog;
+  clone->fEntryIndexDir   = fEntryIndexDir;
+  clone->fMaxWeight       = fMaxWeight;
+  clone->fMaxWgtFudge     = fMaxWgtFudge;
+  clone->fMaxWgtEntries   = fMaxWgtEntries;
+  clone->fMaxEFudge       = fMaxEFudge;
+  clone->fMaxWgtThreads   = fMaxWgtThreads;
+  clone->fMaxWgtCache     = fMaxWgtCache;
+  clone->fNCycles         = fNCycles;
+  clone->fNUse            = fNUse;
+  clone->fGenWeighted     = fGenWeighted;
+  clone->fApplyTiltWeight = fApplyTiltWeight;
+  clone->fDetLocIsSet     = fDetLocIsSet;
+  clone->fLengthUnits     = fLengthUnits;
+  clone->fLengthScaleB2U  = fLengthScaleB2U;
+  clone->fLengthScaleU2B  = fLengthScaleU2B;
+  clone->fBeamZero        = fBeamZero;
+  clone->fBeamRot         = fBeamRot;
+  clone->fBeamRotInv      = fBeamRotInv;
+  clone->fZ0              = fZ0;
+  clone->fIsSphere        = fIsSphere;
+  for (int i = 0; i < 3; ++i) clone->fFluxWindowPtUser[i] = fFluxWindowPtUser[i];
+  clone->fFluxWindowBase  = fFluxWindowBase;
+  clone->fFluxWindowDir1  = fFluxWindowDir1;
+  clone->fFluxWindowDir2  = fFluxWindowDir2;
+  clone->fFluxWindowLen1  = fFluxWindowLen1;
+  clone->fFluxWindowLen2  = fFluxWindowLen2;
+  clone->fFluxWindowNormal     = fFluxWindowNormal;
+  clone->fFluxSphereCenterUser = fFluxSphereCenterUser;
+  clone->fFluxSphereCenterBeam = fFluxSphereCenterBeam;
+  clone->fFluxSphereRadius     = fFluxSphereRadius;
+
+  // the same files through chains of its own; their sizes are known,
+  // so the files are opened only when the clone reads from them
+  clone->fNuFluxTree  = new TChain(fTreeNames[0].c_str());
+  clone->fNuMetaTree  = new TChain(fTreeNames[1].c_str());
+  clone->fChainDk2Nu  = new bsim::Dk2Nu;
+  clone->fCurDk2Nu    = clone->fChainDk2Nu;
+  clone->fCurDkMeta   = new bsim::DkMeta;
+  clone->fCurNuChoice = new bsim::NuChoice;
+  clone->fNuFluxTree->SetBranchAddress("dk2nu",&clone->fChainDk2Nu);
+  clone->fNuMetaTree->SetBranchAddress("dkmeta",&clone->fCurDkMeta);
+  clone->ApplyReadProfile(clone->fNuFluxTree);
+  std::vector<std::string> flist = GetFileList();
+  const Long64_t* foffset = fNuFluxTree->GetTreeOffset();
+  const Long64_t* moffset = fNuMetaTree->GetTreeOffset();
+  for (size_t i = 0; i < flist.size(); ++i) {
+    clone->fNuFluxTree->AddFile(flist[i].c_str(),foffset[i+1]-foffset[i]);
+    clone->fNuMetaTree->AddFile(flist[i].c_str(),moffset[i+1]-moffset[i]);
+  }
+  clone->fNFiles         = fNFiles;
+  clone->fNuTot          = fNuTot;
+  clone->fFilePOTs       = fFilePOTs;
+  clone->fNEntries       = fNEntries;
+  clone->fJobToMetaIndex = fJobToMetaIndex;
+  clone->fNMetaEntries   = fNMetaEntries;
+  clone->fEffPOTsPerNu   = fEffPOTsPerNu;
+
+  // its share of the entries
+  clone->fFirstEntry = ( fNEntries * ithread ) / nthreads;
+  clone->fEndEntry   = ( fNEntries * (ithread+1) ) / nthreads;
+  if ( ! fEntryUsable.empty() ) {
+    clone->fEntryUsable = fEntryUsable;
+    clone->fNEntryUsable = 0;
+    for (Long64_t i = clone->fFirstEntry; i < clone->fEndEntry; ++i)
+      if ( fEntryUsable[i] ) ++clone->fNEntryUsable;
+  }
+  if ( fPickByWeight ) {
+    LOG("Flux", pWARN) << "CloneForThread: clones take their entries in order";
+  }
+  clone->StartDecayCache();
+
+  // random numbers keyed by what is being generated
+  clone->fCounterRng = true;
+  clone->fRngSeed    = seed;
+  clone->fICycle     = 0;
+  clone->fIUse       = 9999999;
+  clone->fIEntry     = clone->fFirstEntry - 1;
+
+  LOG("Flux", pNOTICE) << "CloneForThread " << ithread << " of " << nthreads
+                       << " takes entries [" << clone->fFirstEntry << ","
+                       << clone->fEndEntry << ") with seed " << seed;
+  return clone;
+}
+//___________________________________________________________________________
 void GDk2NuFlux::ScanForMaxWeight(void)
 {
   if (!fDetLocIsSet) {
@@ -673,23 +1580,37 @@ void GDk2NuFlux::ScanForMaxWeight(void)
      return;	
   }
 
-  // scan for the maximum weight
+  // scan for the maximum weight, unless an earlier job already did
 
   double wgtgenmx = 0, enumx = 0;
-  TStopwatch t;
-  t.Start();
-  for (int itry=0; itry < fMaxWgtEntries; ++itry) {
-    this->GenerateNext_weighted();
-    double wgt = this->Weight();
-    if ( wgt > wgtgenmx ) wgtgenmx = wgt;
-    double enu = fCurNuChoice->p4NuBeam.Energy();
-    if ( enu > enumx ) enumx = enu;
+  std::vector<std::string> key;
+  if ( fMaxWgtCache != "" ) key = this->MaxWgtScanKey();
+
+  if ( fMaxWgtCache != "" && this->ReadMaxWgtCache(key,wgtgenmx,enumx) ) {
+    LOG("Flux", pNOTICE) << "Maximum flux weight from " << fMaxWgtCache
+                         << " = " << wgtgenmx << ", energy = " << enumx
+                         << " (" << fMaxWgtEntries << ")";
+  } else {
+    TStopwatch t;
+    t.Start();
+    if ( fMaxWgtThreads > 1 ) {
+      this->ScanForMaxWeightThreaded(wgtgenmx,enumx);
+    } else {
+      for (int itry=0; itry < fMaxWgtEntries; ++itry) {
+        this->GenerateNext_weighted();
+        double wgt = this->Weight();
+        if ( wgt > wgtgenmx ) wgtgenmx = wgt;
+        double enu = fCurNuChoice->p4NuBeam.Energy();
+        if ( enu > enumx ) enumx = enu;
+      }
+    }
+    t.Stop();
+    t.Print("u");
+    LOG("Flux", pNOTICE) << "Maximum flux weight for spin = " 
+                         << wgtgenmx << ", energy = " << enumx
+                         << " (" << fMaxWgtEntries << ")";
+    if ( fMaxWgtCache != "" ) this->WriteMaxWgtCache(key,wgtgenmx,enumx);
   }
-  t.Stop();
-  t.Print("u");
-  LOG("Flux", pNOTICE) << "Maximum flux weight for spin = " 
-                       << wgtgenmx << ", energy = " << enumx
-                       << " (" << fMaxWgtEntries << ")";
 
   if (wgtgenmx > fMaxWeight ) fMaxWeight = wgtgenmx;
   // apply a fudge factor to estimated weight
@@ -706,6 +1627,430 @@ void GDk2NuFlux::ScanForMaxWeight(void)
                        << ", energy = " << fMaxEv;
 
 }
+//___________________________________________________________________________
+void GDk2NuFlux::ScanForMaxWeightThreaded(double& wgtmax, double& enumax)
+{
+  GDk2NuFluxWgtScan scan;
+  scan.fBase      = fFluxWindowBase;
+  scan.fDir1      = fFluxWindowDir1;
+  scan.fDir2      = fFluxWindowDir2;
+  scan.fNormal    = fFluxWindowNormal;
+  scan.fApplyTilt = fApplyTiltWeight;
+  scan.fPdgCList.Copy(*fPdgCList);
+  scan.fNUse      = fNUse;
+  scan.fNTries    = fMaxWgtEntries;
+  scan.fNEntries  = fNEntries;
+  scan.fSeedBase  = RandomGen::Instance()->RndFlux().Integer(kMaxInt);
+  if ( ! fEntryUsable.empty() ) scan.fUsable = &fEntryUsable;
+
+  // each thread reads through a chain of its own
+  std::vector<std::string> flist = GetFileList();
+  std::vector<TChain*> chains;
+  for (int i = 0; i < fMaxWgtThreads; ++i) {
+    TChain* chain = new TChain(fTreeNames[0].c_str());
+    for (size_t j = 0; j < flist.size(); ++j) chain->AddFile(flist[j].c_str());
+    this->ApplyReadProfile(chain);
+    chains.push_back(chain);
+  }
+
+  LOG("Flux", pNOTICE) << "Scan for max weight using " << fMaxWgtThreads
+                       << " threads";
+
+  scan.Run(chains,wgtmax,enumax);
+
+  for (size_t i = 0; i < chains.size(); ++i) delete chains[i];
+}
+
+//___________________________________________________________________________
+std::vector<std::string> GDk2NuFlux::MaxWgtScanKey(void)
+{
+  // everything that the result of a max weight scan depends on
+
+  std::vector<std::string> key;
+
+  std::vector<std::string> flist = GetFileList();
+  for (size_t i = 0; i < flist.size(); ++i) {
+    FileStat_t fstat;
+    gSystem->GetPathInfo(flist[i].c_str(),fstat);
+    std::ostringstream line;
+    line << "file " << flist[i] << " " << fstat.fSize << " " << fstat.fMtime;
+    key.push_back(line.str());
+  }
+
+  std::ostringstream window;
+  window << std::setprecision(17) << "window";
+  for (int i = 0; i < 3; ++i) window << " " << fFluxWindowBase[i];
+  for (int i = 0; i < 3; ++i) window << " " << fFluxWindowDir1[i];
+  for (int i = 0; i < 3; ++i) window << " " << fFluxWindowDir2[i];
+  window << " tilt " << (fApplyTiltWeight?1:0);
+  key.push_back(window.str());
+
+  std::ostringstream flavors;
+  flavors << "flavors";
+  PDGCodeList::const_iterator itr = fPdgCList->begin();
+  for ( ; itr != fPdgCList->end(); ++itr) flavors << " " << (*itr);
+  key.push_back(flavors.str());
+
+  std::ostringstream other;
+  other << std::setprecision(17) << "units " << fLengthUnits
+        << " scan " << fMaxWgtEntries << " reuse " << fNUse
+        << " threads " << ((fMaxWgtThreads > 1) ? "many" : "one");
+  key.push_back(other.str());
+
+  return key;
+}
+
+//___________________________________________________________________________
+bool GDk2NuFlux::ReadMaxWgtCache(const std::vector<std::string>& key,
+                                 double& wgtmax, double& enumax)
+{
+  // the cache file is a series of blocks:
+  //   begin
+  //   <key lines>
+  //   result <wgtmax> <enumax>
+  //   end
+
+  TString fname = fMaxWgtCache.c_str();
+  gSystem->ExpandPathName(fname);
+  std::ifstream in(fname.Data());
+  if ( ! in ) return false;
+
+  bool found = false;
+  std::string line;
+  std::vector<std::string> block;
+  while ( std::getline(in,line) ) {
+    if ( line == "begin" ) {
+      block.clear();
+    } else if ( line.compare(0,7,"result ") == 0 ) {
+      if ( block == key ) {
+        std::istringstream vals(line.substr(7));
+        vals >> wgtmax >> enumax;
+        found = ! vals.fail();
+      }
+    } else if ( line != "end" ) {
+      block.push_back(line);
+    }
+    // don't stop at the first match, a later scan supersedes it
+  }
+  return found;
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::WriteMaxWgtCache(const std::vector<std::string>& key,
+                                  double wgtmax, double enumax)
+{
+  TString fname = fMaxWgtCache.c_str();
+  gSystem->ExpandPathName(fname);
+
+  // build the whole block and append it in one go, other jobs might be
+  // writing to the same file
+  std::ostringstream block;
+  block << "begin\n";
+  for (size_t i = 0; i < key.size(); ++i) block << key[i] << "\n";
+  block << std::setprecision(17)
+        << "result " << wgtmax << " " << enumax << "\n"
+        << "end\n";
+
+  std::ofstream out(fname.Data(),std::ios::app);
+  out << block.str() << std::flush;
+  if ( ! out ) {
+    LOG("Flux", pWARN) << "Could not save max weight scan to " << fname.Data();
+  }
+}
+
+//___________________________________________________________________________
+// per file index of entries: a text header line
+//   dk2nuidx <version> <nentries> <file size> <file mtime>
+// followed by nentries Short_t flavors and nentries Float_t energy bounds
+static const int kEntryIndexVersion = 1;
+
+static std::string EntryIndexName(const std::string& dir,
+                                  const std::string& fname)
+{
+  // files in different directories may share a name
+  TString base = gSystem->BaseName(fname.c_str());
+  std::ostringstream name;
+  name << dir << "/" << base.Data() << "."
+       << std::hex << TString(fname.c_str()).Hash() << ".dk2nuidx";
+  TString expanded = name.str().c_str();
+  gSystem->ExpandPathName(expanded);
+  return expanded.Data();
+}
+
+void GDk2NuFlux::LoadEntryIndex(void)
+{
+  fEntryNType.clear();
+  fEntryEMax.clear();
+  fEntryNType.reserve(fNEntries);
+  fEntryEMax.reserve(fNEntries);
+
+  // GetEntries() has been called, so the offsets of all files are known
+  std::vector<std::string> flist = GetFileList();
+  const Long64_t* offset = fNuFluxTree->GetTreeOffset();
+  for (size_t i = 0; i < flist.size(); ++i) {
+    Long64_t nentries = offset[i+1] - offset[i];
+    if ( ! this->ReadEntryIndex(flist[i],nentries) ) {
+      this->BuildEntryIndex(flist[i],nentries);
+    }
+  }
+
+  if ( (Long64_t)fEntryNType.size() != fNEntries ) {
+    LOG("Flux", pERROR)
+      << "Entry index has " << fEntryNType.size() << " entries, not "
+      << fNEntries << "; not using it";
+    fEntryNType.clear();
+    fEntryEMax.clear();
+  }
+
+  this->UpdateEntryUsable();
+}
+
+//___________________________________________________________________________
+bool GDk2NuFlux::ReadEntryIndex(const std::string& fname, Long64_t nentries)
+{
+  std::string iname = EntryIndexName(fEntryIndexDir,fname);
+  std::ifstream in(iname.c_str(),std::ios::binary);
+  if ( ! in ) return false;
+
+  FileStat_t fstat;
+  gSystem->GetPathInfo(fname.c_str(),fstat);
+
+  std::string header;
+  std::getline(in,header);
+  std::istringstream hs(header);
+  std::string magic;
+  int version = 0;
+  Long64_t n = -1, size = -1;
+  Long_t mtime = -1;
+  hs >> magic >> version >> n >> size >> mtime;
+  if ( hs.fail() || magic != "dk2nuidx" || version != kEntryIndexVersion ||
+       n != nentries || size != fstat.fSize || mtime != fstat.fMtime ) {
+    LOG("Flux", pNOTICE) << "Entry index " << iname << " is out of date";
+    return false;
+  }
+
+  size_t n0 = fEntryNType.size();
+  fEntryNType.resize(n0+n);
+  fEntryEMax.resize(n0+n);
+  if ( n > 0 ) {
+    in.read((char*)&fEntryNType[n0],n*sizeof(Short_t));
+    in.read((char*)&fEntryEMax[n0],n*sizeof(Float_t));
+  }
+  if ( ! in ) {
+    LOG("Flux", pWARN) << "Entry index " << iname << " is truncated";
+    fEntryNType.resize(n0);
+    fEntryEMax.resize(n0);
+    return false;
+  }
+  return true;
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::BuildEntryIndex(const std::string& fname, Long64_t nentries)
+{
+  LOG("Flux", pNOTICE) << "Building entry index for " << fname;
+
+  TFile tf(fname.c_str());
+  TTree* ftree = (TTree*)tf.Get(fTreeNames[0].c_str());
+  Long64_t n = ( ftree ) ? ftree->GetEntries() : 0;
+  if ( n != nentries ) {
+    LOG("Flux", pERROR) << "Entry index: " << fname << " has " << n
+                        << " entries, expected " << nentries;
+    n = 0;
+  }
+
+  size_t n0 = fEntryNType.size();
+  fEntryNType.resize(n0+nentries,0);
+  fEntryEMax.resize(n0+nentries,0);
+
+  if ( n > 0 ) {
+    bsim::Dk2Nu* dk2nu = new bsim::Dk2Nu;
+    ftree->SetBranchAddress("dk2nu",&dk2nu);
+    ftree->SetBranchStatus("*",0);
+    ftree->SetBranchStatus("dk2nu",1);
+    ftree->SetBranchStatus("decay*",1);
+    for (Long64_t i = 0; i < n; ++i) {
+      ftree->GetEntry(i);
+      fEntryNType[n0+i] = dk2nu->decay.ntype;
+      fEntryEMax[n0+i]  = bsim::calcEnuMax(dk2nu->decay);
+    }
+    delete ftree;
+    delete dk2nu;
+  }
+  tf.Close();
+
+  // write to a temporary name first, other jobs might be reading
+  std::string iname = EntryIndexName(fEntryIndexDir,fname);
+  std::ostringstream tmpname;
+  tmpname << iname << ".tmp" << gSystem->GetPid();
+
+  FileStat_t fstat;
+  gSystem->GetPathInfo(fname.c_str(),fstat);
+
+  std::ofstream out(tmpname.str().c_str(),std::ios::binary);
+  out << "dk2nuidx " << kEntryIndexVersion << " " << nentries << " "
+      << fstat.fSize << " " << fstat.fMtime << "\n";
+  if ( nentries > 0 ) {
+    out.write((const char*)&fEntryNType[n0],nentries*sizeof(Short_t));
+    out.write((const char*)&fEntryEMax[n0],nentries*sizeof(Float_t));
+  }
+  out.close();
+  if ( ! out || gSystem->Rename(tmpname.str().c_str(),iname.c_str()) != 0 ) {
+    LOG("Flux", pWARN) << "Could not save entry index " << iname;
+    gSystem->Unlink(tmpname.str().c_str());
+  }
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::UpdateEntryUsable(void)
+{
+  // which entries have a flavor that is asked for
+
+  fEntryUsable.clear();
+  fNEntryUsable = 0;
+  if ( fEntryNType.empty() ) return;
+
+  fEntryUsable.resize(fEntryNType.size(),false);
+  double emax = 0;
+  for (size_t i = 0; i < fEntryNType.size(); ++i) {
+    if ( ! fPdgCList->ExistsInPDGCodeList(fEntryNType[i]) ) continue;
+    fEntryUsable[i] = true;
+    ++fNEntryUsable;
+    if ( fEntryEMax[i] > emax ) emax = fEntryEMax[i];
+  }
+
+  LOG("Flux", pNOTICE)
+    << "Entry index: " << fNEntryUsable << " of " << fEntryNType.size()
+    << " entries have a flavor in " << *fPdgCList
+    << ", with E_nu at most " << emax;
+
+  this->StopPrefetch();  // it follows the old list
+}
+
+//___________________________________________________________________________
+void GDk2NuFlux::ClearPickTable(void)
+{
+  // the bounds and the alias table go together; an empty fPickWgtMax
+  // marks the lot for a rebuild
+
+  fPickWgtMax.clear();
+  fPickProb.clear();
+  fPickAlias.clear();
+  fPickWgtMean = 0;
+}
+//___________________________________________________________________________
+void GDk2NuFlux::BuildPickTable(void)
+{
+  // bound the weight of every entry at the flux window, then set up an
+  // alias table (Walker/Vose) to pick entries in proportion to the bounds
+
+  this->ClearPickTable();
+  if ( ! fNuFluxTree || fNEntries == 0 ) return;
+  if ( fNEntries > kMaxInt ) {
+    LOG("Flux", pERROR)
+      << "Too many entries (" << fNEntries << ") to pick by weight, "
+      << "taking them in order";
+    fPickByWeight = false;
+    return;
+  }
+
+  LOG("Flux", pNOTICE) << "Bounding the weights of " << fNEntries
+                       << " entries at the flux window";
+  TStopwatch t;
+  t.Start();
+
+  TChain* chain = new TChain(fTreeNames[0].c_str());
+  std::vector<std::string> flist = GetFileList();
+  for (size_t i = 0; i < flist.size(); ++i) chain->AddFile(flist[i].c_str());
+  bsim::Dk2Nu* dk2nu = new bsim::Dk2Nu;
+  chain->SetBranchAddress("dk2nu",&dk2nu);
+  chain->SetBranchStatus("*",0);
+  chain->SetBranchStatus("dk2nu",1);
+  chain->SetBranchStatus("decay*",1);
+
+  const TVector3 base = fFluxWindowBase.Vect();
+  const TVector3 dir1 = fFluxWindowDir1.Vect();
+  const TVector3 dir2 = fFluxWindowDir2.Vect();
+
+  // entries that can't be used keep a bound of 0 and are never picked
+  fPickWgtMax.resize(fNEntries,0);
+  double wgtsum = 0, wgtmax = 0, enumax = 0;
+  for (Long64_t i = 0; i < fNEntries; ++i) {
+    if ( ! fEntryUsable.empty() && ! fEntryUsable[i] ) continue;
+    dk2nu->clear();
+    chain->GetEntry(i);
+    const bsim::Decay& decay = dk2nu->decay;
+    if ( ! fPdgCList->ExistsInPDGCodeList(decay.ntype) ) continue;
+
+    double enu = 0, wgt_xy = 0;
+    if ( bsim::calcEnuWgtMax(decay,base,dir1,dir2,enu,wgt_xy) != 0 ) continue;
+    // the tilt weight is at most 1; allow for the rounding to float
+    fPickWgtMax[i] = decay.nimpwt * wgt_xy * ( 1.0 + 1.0e-6 );
+
+    wgtsum += fPickWgtMax[i];
+    if ( fPickWgtMax[i] > wgtmax ) wgtmax = fPickWgtMax[i];
+    if ( enu > enumax ) enumax = enu;
+  }
+  chain->ResetBranchAddresses();
+  delete dk2nu;
+  delete chain;
+
+  fPickWgtMean = wgtsum / fNEntries;
+  if ( wgtsum > 0 ) {
+    // scaled to a mean of 1, entries below 1 are topped up from one above
+    Int_t n = fNEntries;
+    std::vector<double> scaled(n);
+    std::vector<Int_t>  small, large;
+    fPickProb.resize(n,1);
+    fPickAlias.resize(n);
+    for (Int_t i = 0; i < n; ++i) {
+      fPickAlias[i] = i;
+      scaled[i] = fPickWgtMax[i] / fPickWgtMean;
+      if ( scaled[i] < 1.0 ) small.push_back(i);
+      else                   large.push_back(i);
+    }
+    while ( ! small.empty() && ! large.empty() ) {
+      Int_t is = small.back();
+      Int_t il = large.back();
+      small.pop_back();
+      fPickProb[is]  = scaled[is];
+      fPickAlias[is] = il;
+      scaled[il] -= ( 1.0 - scaled[is] );
+      if ( scaled[il] < 1.0 ) {
+        large.pop_back();
+        small.push_back(il);
+      }
+    }
+    // whatever is left is 1 up to rounding, and kept for sure
+  }
+
+  // the largest bound is a true maximum, no need to scan for one
+  if ( fMaxWeight <= 0 ) fMaxWeight = wgtmax;
+  // adjust max energy?
+  if ( enumax*fMaxEFudge > fMaxEv ) {
+    LOG("Flux", pNOTICE) << "Adjust max: was=" << fMaxEv
+                         << " now " << enumax << "*" << fMaxEFudge
+                         << " = " << enumax*fMaxEFudge;
+    fMaxEv = enumax * fMaxEFudge;
+  }
+
+  t.Stop();
+  t.Print("u");
+  LOG("Flux", pNOTICE) << "Entry weight bounds: mean " << fPickWgtMean
+                       << ", max " << wgtmax << ", energy at most " << enumax;
+}
+
+//___________________________________________________________________________
+Long64_t GDk2NuFlux::PickEntry(void)
+{
+  // a uniformly chosen slot keeps its own entry with probability
+  // fPickProb, otherwise gives its alias
+  RandomGen* rnd = RandomGen::Instance();
+  Long64_t ientry = rnd->RndFlux().Integer((UInt_t)fPickProb.size());
+  if ( rnd->RndFlux().Rndm() >= fPickProb[ientry] ) ientry = fPickAlias[ientry];
+  return ientry;
+}
+
 //___________________________________________________________________________
 void GDk2NuFlux::SetFluxParticles(const PDGCodeList & particles)
 {
@@ -713,9 +2058,12 @@ void GDk2NuFlux::SetFluxParticles(const PDGCodeList & particles)
      fPdgCList = new PDGCodeList;
   }
   fPdgCList->Copy(particles);
+  this->ClearPickTable();  // entries of other flavors may now count
 
   LOG("Flux", pINFO)
     << "Declared list of neutrino species: " << *fPdgCList;
+
+  this->UpdateEntryUsable();
 }
 //___________________________________________________________________________
 void GDk2NuFlux::SetMaxEnergy(double Ev)
@@ -784,6 +2132,7 @@ void GDk2NuFlux::SetFluxWindow(TVector3 p0, TVector3 p1, TVector3 p2)
   fFluxWindowLen1   = fFluxWindowDir1.Mag();
   fFluxWindowLen2   = fFluxWindowDir2.Mag();
   fFluxWindowNormal = fFluxWindowDir1.Vect().Cross(fFluxWindowDir2.Vect()).Unit();
+  this->ClearPickTable();  // bounds were for the old window
 
   double dot = fFluxWindowDir1.Dot(fFluxWindowDir2);
   if ( TMath::Abs(dot) > 1.0e-8 )
@@ -937,6 +2286,7 @@ void GDk2NuFlux::User2BeamP4 (const TLorentzVector& usrp4,
 //___________________________________________________________________________
 void GDk2NuFlux::PrintCurrent(void)
 {
+  this->LoadFullDk2Nu();
   LOG("Flux", pNOTICE) << "CurrentEntry:\n" 
                        << fCurDk2Nu->AsString() << "\n" 
                        << fCurNuChoice->AsString();
@@ -976,12 +2326,36 @@ void GDk2NuFlux::Initialize(void)
   fTreeNames[1]    = "dkmetaTree";
   fNuFluxTree      =  0;
   fNuMetaTree      =  0;
+  fNuAncTree       =  0;
+  fAncReader       =  0;
+  fChainDk2Nu      =  0;
+  fReadProfile     = "full";
+  fReadDecayOnly   = false;
+  fCurDk2NuFull    = true;
+  fPrefetchDepth   =  0;
+  fPrefetch        =  0;
+  fDecayCacheMB    =  0;
+  fDecayCache      =  0;
+  fCurTdk          =  0;
+  fEntryIndexDir   = "";
+  fNEntryUsable    =  0;
+  fPickByWeight    = false;
+  fPickWgtMean     =  0;
+  fNPicked         =  0;
   fCurDk2Nu        =  0;
   fCurDkMeta       =  0;
   fCurNuChoice     =  0;
+  fBatch           = new GDk2NuFluxBatch;
   fNFiles          =  0;
+  fNMetaEntries    =  0;
+  fFileCatalog     = "";
 
   fNEntries        =  0;
+  fFirstEntry      =  0;
+  fEndEntry        =  0;
+  fCounterRng      = false;
+  fRngSeed         =  0;
+  fNTdkZeroMsg     =  5;
   fIEntry          = -1;
   fNCycles         =  0;
   fICycle          =  0;
@@ -995,6 +2369,8 @@ void GDk2NuFlux::Initialize(void)
   fMaxWgtFudge     =  1.05;
   fMaxWgtEntries   = 2500000;
   fMaxEFudge       =  0;
+  fMaxWgtThreads   =  1;
+  fMaxWgtCache     = "";
 
   fZ0              =  -3.4e38;
   fSumWeight       =  0;
@@ -1055,9 +2431,16 @@ void GDk2NuFlux::CleanUp(void)
 {
   LOG("Flux", pNOTICE) << "Cleaning up...";
 
+  this->StopPrefetch();
+  this->StopDecayCache();
+  if ( fAncReader )   delete fAncReader;
+  if ( fNuAncTree )   delete fNuAncTree;
+  fAncReader = 0;
+  fNuAncTree = 0;
   if ( fPdgCList )    delete fPdgCList;
   if ( fPdgCListRej ) delete fPdgCListRej;
   if ( fCurNuChoice ) delete fCurNuChoice;
+  if ( fBatch )       delete fBatch;
 
   LOG("Flux", pNOTICE)
     << " flux file cycles: " << fICycle << " of " << fNCycles 
@@ -1065,47 +2448,43 @@ void GDk2NuFlux::CleanUp(void)
 }
 
 //___________________________________________________________________________
-void GDk2NuFlux::AddFile(TTree* ftree, TTree* mtree, string fname)
+void GDk2NuFlux::AddFile(string fname, Long64_t nentries, double potsum,
+                         const std::vector<int>& jobs)
 {
-  // Add a file to the chain
+  // Add a file to the chain, given its summary (see GDk2NuFluxCatalog);
+  // with the number of entries known the chains needn't open it yet
 
-  ULong64_t nentries = ftree->GetEntries();
-
-  // generally files will only have one meta data entry, but if they've
-  // been combined (i.e. "hadd") there might be more than one.
-  int nmeta = mtree->GetEntries();
-  double potsum = 0;
-  bsim::DkMeta* dkmeta = new bsim::DkMeta;
-  mtree->SetBranchAddress("dkmeta",&dkmeta);
-  for (int imeta = 0; imeta < nmeta; ++imeta ) {
-    mtree->GetEntry(imeta);
-    double potentry = dkmeta->pots;
-    potsum += potentry;
-  }
-  delete dkmeta;
-
-  // don't need these anymore
-  delete ftree;
-  delete mtree;
+  int nmeta = jobs.size();
 
   // make sure the chains are defined and a branch object attached
   if ( ! fNuFluxTree ) {
     fNuFluxTree  = new TChain(fTreeNames[0].c_str());
     fNuMetaTree  = new TChain(fTreeNames[1].c_str());
-    fCurDk2Nu    = new bsim::Dk2Nu;
+    fChainDk2Nu  = new bsim::Dk2Nu;
+    fCurDk2Nu    = fChainDk2Nu;
     fCurDkMeta   = new bsim::DkMeta;
     fCurNuChoice = new bsim::NuChoice;
-    fNuFluxTree->SetBranchAddress("dk2nu",&fCurDk2Nu);
+    fNuFluxTree->SetBranchAddress("dk2nu",&fChainDk2Nu);
     fNuMetaTree->SetBranchAddress("dkmeta",&fCurDkMeta);
+    this->ApplyReadProfile(fNuFluxTree);
+  }
+  this->StopPrefetch();  // its chain lacks the new file
+  this->StopDecayCache();
+  this->ClearPickTable();
+  if ( fAncReader ) {    // redone with the new file when it's needed
+    delete fAncReader;
+    delete fNuAncTree;
+    fAncReader = 0;
+    fNuAncTree = 0;
   }
 
   // add the file to the chains
-  int stat0 = fNuFluxTree->AddFile(fname.c_str());
-  int stat1 = fNuMetaTree->AddFile(fname.c_str());
+  int stat0 = fNuFluxTree->AddFile(fname.c_str(),nentries);
+  int stat1 = fNuMetaTree->AddFile(fname.c_str(),nmeta);
 
   LOG("Flux",pINFO)
     << "flux->AddFile() of " << nentries
-    << " " << ((mtree)?"[+meta]":"[no-meta]")
+    << " [+meta]"
     << " [status=" << stat0 << "," << stat1 << "]"
     << nentries << " (" << nmeta << ")"
     << " entries in file: " << fname;
@@ -1114,6 +2493,24 @@ void GDk2NuFlux::AddFile(TTree* ftree, TTree* mtree, string fname)
     SLOG("GDk2NuFlux", pFATAL) << "Add: \"" << fname << "\" failed";
   }
 
+  // where each job's metadata will be in the meta chain
+  for (int imeta = 0; imeta < nmeta; ++imeta ) {
+    int mjob  = jobs[imeta];
+    int mindx = fNMetaEntries + imeta;
+    // there shouldn't already be an entry in the map
+    // complain if there is
+    std::map<int,int>::const_iterator mitr = fJobToMetaIndex.find(mjob);
+    if ( mitr == fJobToMetaIndex.end() ) {
+      fJobToMetaIndex[mjob] = mindx;  // make an entry
+    } else {
+      LOG("Flux", pERROR) << "AddFile already had an entry for job "
+                          << mjob << " at " << mitr->second
+                          << " which conflicts with new entry at "
+                          << mindx;
+    }
+  }
+  fNMetaEntries += nmeta;
+
   fNuTot    += nentries;
   fFilePOTs += potsum;
   fNFiles++;
@@ -1244,11 +2641,22 @@ void GDk2NuFlux::PrintConfig()
     << fpattout.str()
     << "\n wgt max=" << fMaxWeight << " fudge=" << fMaxWgtFudge << " using scan of "
     << fMaxWgtEntries << " entries"
+    << " (" << fMaxWgtThreads << " threads, cache \"" << fMaxWgtCache << "\")"
     << "\n Z0 pushback " << fZ0
     << "\n used entry " << fIEntry << " " << fIUse << "/" << fNUse
     << " times, in " << fICycle << "/" << fNCycles << " cycles"
     << "\n SumWeight " << fSumWeight << " for " << fNNeutrinos << " neutrino entries"
     << "\n EffPOTsPerNu " << fEffPOTsPerNu << " AccumPOTs " << fAccumPOTs
+    << "\n ReadProfile: \"" << fReadProfile << "\""
+    << ", PrefetchDepth: " << fPrefetchDepth
+    << ", DecayCache: " << fDecayCacheMB << " MB"
+    << " (" << ( fDecayCache ? fDecayCache->NCached() : 0 ) << " entries)"
+    << "\n FileCatalog: \"" << fFileCatalog << "\""
+    << "\n EntryIndexDir: \"" << fEntryIndexDir << "\""
+    << " (" << ( fEntryUsable.empty() ? "not used" : "used" ) << ", "
+    << fNEntryUsable << " usable entries)"
+    << "\n WeightedEntrySelection: \"" << (fPickByWeight?"true":"false") << "\""
+    << " (mean weight bound " << fPickWgtMean << ")"
     << "\n GenWeighted: \"" << (fGenWeighted?"true":"false") << "\", "
     << "ApplyTiltWeight: \"" << (fApplyTiltWeight?"true":"false") << "\", "
     << "Detector location set: \"" << (fDetLocIsSet?"true":"false") << "\", "
@@ -1295,6 +2703,466 @@ std::vector<std::string> GDk2NuFlux::GetFileList()
   return flist;
 }
 
+//___________________________________________________________________________
+GDk2NuFluxPrefetch::GDk2NuFluxPrefetch(TChain* chain, Long64_t first,
+                                       Long64_t end, int depth,
+                                       const std::vector<bool>* usable)
+  : fChain(chain), fFirstEntry(first), fEndEntry(end), fDepth(depth),
+    fUsable(usable), fReadDk2Nu(new bsim::Dk2Nu), fLastAsked(-1),
+    fInUse(0), fStop(false), fMutex(), fCond(&fMutex), fThread(0)
+{
+  // ROOT's global state must be guarded once a second thread does I/O
+  TThread::Initialize();
+
+  fChain->SetBranchAddress("dk2nu",&fReadDk2Nu);
+
+  // one more than the depth: the caller holds one while the rest fill up
+  for (int i = 0; i <= depth; ++i) fFree.push_back(new bsim::Dk2Nu);
+
+  fThread = new TThread("GDk2NuFluxPrefetch",
+                        &GDk2NuFluxPrefetch::ThreadFunc,(void*)this);
+  fThread->Run();
+}
+
+//___________________________________________________________________________
+GDk2NuFluxPrefetch::~GDk2NuFluxPrefetch()
+{
+  fMutex.Lock();
+  fStop = true;
+  fCond.Broadcast();
+  fMutex.UnLock();
+
+  fThread->Join();
+  delete fThread;
+
+  for (size_t i = 0; i < fFree.size();  ++i) delete fFree[i];
+  for (size_t i = 0; i < fReady.size(); ++i) delete fReady[i].second;
+  if ( fInUse ) delete fInUse;
+  delete fChain;
+  delete fReadDk2Nu;
+}
+
+//___________________________________________________________________________
+bsim::Dk2Nu* GDk2NuFluxPrefetch::Next(Long64_t ientry,
+                                      const GDk2NuFluxDecayCache* cache)
+{
+  fMutex.Lock();
+
+  if ( fInUse ) fFree.push_back(fInUse);
+  fInUse = 0;
+
+  // where ientry is in what was asked for; what comes before it was
+  // skipped (served from the decay cache, say) and needn't be read
+  size_t iahead = 0;
+  while ( iahead < fAhead.size() && fAhead[iahead] != ientry ) ++iahead;
+
+  if ( iahead < fAhead.size() ) {
+    size_t nread = fAhead.size() - fToRead.size();  // being or been read
+    for (size_t i = nread; i < iahead; ++i) fToRead.pop_front();
+    fAhead.erase(fAhead.begin(),fAhead.begin()+iahead);
+  } else {
+    // not what was read ahead (first call, or the caller jumped to
+    // another entry): start over from ientry
+    fAhead.clear();
+    fToRead.clear();
+    fAhead.push_back(ientry);
+    fToRead.push_back(ientry);
+    fLastAsked = ientry;
+  }
+  fAhead.pop_front();  // ientry, about to be handed out
+
+  // keep fDepth entries asked for beyond this one
+  while ( (int)fAhead.size() < fDepth ) {
+    Long64_t jentry = NextToRead(fLastAsked,cache);
+    if ( jentry < 0 ) break;
+    fAhead.push_back(jentry);
+    fToRead.push_back(jentry);
+    fLastAsked = jentry;
+  }
+  fCond.Broadcast();
+
+  // records of entries that were skipped come first; give them back
+  while ( fReady.empty() || fReady.front().first != ientry ) {
+    if ( fReady.empty() ) {
+      fCond.Wait();
+    } else {
+      fFree.push_back(fReady.front().second);
+      fReady.pop_front();
+      fCond.Broadcast();
+    }
+  }
+
+  fInUse = fReady.front().second;
+  fReady.pop_front();
+  fCond.Broadcast();
+
+  fMutex.UnLock();
+  return fInUse;
+}
+
+//___________________________________________________________________________
+Long64_t GDk2NuFluxPrefetch::After(Long64_t ientry) const
+{
+  // the entry GenerateNext_weighted() moves on to after ientry
+  do {
+    ientry = ( ientry+1 < fEndEntry ) ? ientry+1 : fFirstEntry;
+  } while ( fUsable && ! (*fUsable)[ientry] );
+  return ientry;
+}
+
+//___________________________________________________________________________
+Long64_t GDk2NuFluxPrefetch::NextToRead(Long64_t ientry,
+                                        const GDk2NuFluxDecayCache* cache) const
+{
+  // the next entry after ientry that will have to come from file;
+  // -1 if the cache holds all of them
+  Long64_t jentry = ientry;
+  for (Long64_t n = fFirstEntry; n < fEndEntry; ++n) {
+    jentry = After(jentry);
+    if ( ! cache || ! cache->Has(jentry) ) return jentry;
+  }
+  return -1;
+}
+
+//___________________________________________________________________________
+void* GDk2NuFluxPrefetch::ThreadFunc(void* arg)
+{
+  ((GDk2NuFluxPrefetch*)arg)->ReadLoop();
+  return 0;
+}
+
+//___________________________________________________________________________
+void GDk2NuFluxPrefetch::ReadLoop()
+{
+  // read the entries Next() asks for, in the order asked
+
+  fMutex.Lock();
+  while ( true ) {
+    while ( ! fStop && ( fFree.empty() || fToRead.empty() ) ) fCond.Wait();
+    if ( fStop ) break;
+
+    bsim::Dk2Nu* rec    = fFree.back();
+    Long64_t     ientry = fToRead.front();
+    fFree.pop_back();
+    fToRead.pop_front();
+    fMutex.UnLock();
+
+    // the same as ResetCurrent() + GetEntry() would leave in fCurDk2Nu
+    fReadDk2Nu->clear();
+    fChain->GetEntry(ientry);
+    *rec = *fReadDk2Nu;
+
+    fMutex.Lock();
+    fReady.push_back(Record(ientry,rec));
+    fCond.Broadcast();
+  }
+  fMutex.UnLock();
+}
+
+//___________________________________________________________________________
+// # of tries per chunk; fixed, so that the chunks (and the result) don't
+// depend on the number of threads
+static const long int kWgtScanChunk = 10000;
+
+void GDk2NuFluxWgtScan::Run(const std::vector<TChain*>& chains,
+                            double& wgtmax, double& enumax)
+{
+  TThread::Initialize();
+
+  fNextChunk = 0;
+  fWgtMax    = 0;
+  fEnuMax    = 0;
+
+  std::vector<Worker>   workers(chains.size());
+  std::vector<TThread*> threads(chains.size());
+  for (size_t i = 0; i < chains.size(); ++i) {
+    workers[i].scan  = this;
+    workers[i].chain = chains[i];
+    threads[i] = new TThread("GDk2NuFluxWgtScan",
+                             &GDk2NuFluxWgtScan::ThreadFunc,(void*)&workers[i]);
+    threads[i]->Run();
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i]->Join();
+    delete threads[i];
+  }
+
+  wgtmax = fWgtMax;
+  enumax = fEnuMax;
+}
+
+//___________________________________________________________________________
+void* GDk2NuFluxWgtScan::ThreadFunc(void* arg)
+{
+  Worker* worker = (Worker*)arg;
+  worker->scan->Scan(worker->chain);
+  return 0;
+}
+
+//___________________________________________________________________________
+void GDk2NuFluxWgtScan::Scan(TChain* chain)
+{
+  // same weight and energy as GenerateNext_weighted() gives
+
+  bsim::Dk2Nu* dk2nu = new bsim::Dk2Nu;
+  chain->SetBranchAddress("dk2nu",&dk2nu);
+
+  long int nchunks = ( fNTries + kWgtScanChunk - 1 ) / kWgtScanChunk;
+  Long64_t ientry  = -1;
+  double   wgtmax  = 0, enumax = 0;
+
+  while ( true ) {
+    fMutex.Lock();
+    long int ichunk = fNextChunk++;
+    fMutex.UnLock();
+    if ( ichunk >= nchunks ) break;
+
+    UInt_t seed = fSeedBase + (UInt_t)ichunk * 2654435761U;
+    TRandom3 rnd( (seed != 0) ? seed : 1 );  // 0 would seed from the clock
+
+    long int itry0 = ichunk * kWgtScanChunk;
+    long int itry1 = TMath::Min(itry0 + kWgtScanChunk, fNTries);
+    for (long int itry = itry0; itry < itry1; ++itry) {
+      Long64_t jentry = ( itry / fNUse ) % fNEntries;
+      if ( fUsable && ! (*fUsable)[jentry] ) continue;
+      if ( jentry != ientry ) {
+        ientry = jentry;
+        dk2nu->clear();
+        chain->GetEntry(ientry);
+      }
+      const bsim::Decay& decay = dk2nu->decay;
+      if ( ! fPdgCList.ExistsInPDGCodeList(decay.ntype) ) continue;
+
+      double r1 = rnd.Rndm();
+      double r2 = rnd.Rndm();
+      TLorentzVector x4 = fBase;
+      x4 += ( r1*fDir1 + r2*fDir2 );
+
+      double enu = 0, wgt_xy = 0;
+      bsim::calcEnuWgt(decay,x4.Vect(),enu,wgt_xy);
+
+      double wgt = decay.nimpwt * wgt_xy;
+      if ( fApplyTilt ) {
+        TVector3 dirNu = ( x4.Vect() - TVector3(decay.vx,decay.vy,decay.vz) ).Unit();
+        wgt *= TMath::Abs( dirNu.Dot(fNormal) );
+      }
+
+      if ( wgt > wgtmax ) wgtmax = wgt;
+      if ( enu > enumax ) enumax = enu;
+    }
+  }
+
+  fMutex.Lock();
+  if ( wgtmax > fWgtMax ) fWgtMax = wgtmax;
+  if ( enumax > fEnuMax ) fEnuMax = enumax;
+  fMutex.UnLock();
+
+  chain->ResetBranchAddresses();
+  delete dk2nu;
+}
+
+//___________________________________________________________________________
+void GDk2NuFluxCatalog::Read(const std::string& fname)
+{
+  // one line per file:
+  //   size mtime nentries pots fluxtree metatree njobs job... path
+
+  std::ifstream in(fname.c_str());
+  if ( ! in ) return;
+
+  std::string line;
+  std::getline(in,line);
+  if ( line != "dk2nucat 1" ) {
+    LOG("Flux", pWARN) << "File catalog " << fname << " isn't one; ignored";
+    return;
+  }
+
+  while ( std::getline(in,line) ) {
+    std::istringstream ls(line);
+    Entry entry;
+    size_t njobs = 0;
+    ls >> entry.size >> entry.mtime >> entry.nentries >> entry.pots
+       >> entry.treenames[0] >> entry.treenames[1] >> njobs;
+    entry.jobs.resize(njobs);
+    for (size_t i = 0; i < njobs; ++i) ls >> entry.jobs[i];
+    std::string path;
+    std::getline(ls >> std::ws,path);
+    if ( ls.fail() || path == "" ) {
+      LOG("Flux", pWARN) << "File catalog " << fname
+                         << " has a bad line: " << line;
+      continue;
+    }
+    fEntries[path] = entry;
+  }
+}
+
+//___________________________________________________________________________
+void GDk2NuFluxCatalog::Write(const std::string& fname)
+{
+  // write to a temporary name first, other jobs might be reading
+  std::ostringstream tmpname;
+  tmpname << fname << ".tmp" << gSystem->GetPid();
+
+  std::ofstream out(tmpname.str().c_str());
+  out << "dk2nucat 1\n" << std::setprecision(17);
+  std::map<std::string,Entry>::const_iterator itr = fEntries.begin();
+  for ( ; itr != fEntries.end(); ++itr) {
+    const Entry& entry = itr->second;
+    out << entry.size << " " << entry.mtime << " " << entry.nentries << " "
+        << entry.pots << " " << entry.treenames[0] << " "
+        << entry.treenames[1] << " " << entry.jobs.size();
+    for (size_t i = 0; i < entry.jobs.size(); ++i) out << " " << entry.jobs[i];
+    out << " " << itr->first << "\n";
+  }
+  out.close();
+  if ( ! out || gSystem->Rename(tmpname.str().c_str(),fname.c_str()) != 0 ) {
+    LOG("Flux", pWARN) << "Could not save file catalog " << fname;
+    gSystem->Unlink(tmpname.str().c_str());
+    return;
+  }
+  fChanged = false;
+}
+
+//___________________________________________________________________________
+bool GDk2NuFluxCatalog::Find(const std::string& path,
+                             const std::string treenames[2],
+                             Entry& entry) const
+{
+  std::map<std::string,Entry>::const_iterator itr = fEntries.find(path);
+  if ( itr == fEntries.end() ) return false;
+
+  FileStat_t fstat;
+  if ( gSystem->GetPathInfo(path.c_str(),fstat) != 0 ) return false;
+
+  const Entry& found = itr->second;
+  if ( found.size != fstat.fSize || found.mtime != fstat.fMtime ||
+       found.treenames[0] != treenames[0] ||
+       found.treenames[1] != treenames[1] ) return false;
+
+  entry = found;
+  return true;
+}
+
+//___________________________________________________________________________
+void GDk2NuFluxCatalog::Add(const std::string& path,
+                            const std::string treenames[2],
+                            TTree* ftree, TTree* mtree, Entry& entry)
+{
+  FileStat_t fstat;
+  gSystem->GetPathInfo(path.c_str(),fstat);
+  entry.size         = fstat.fSize;
+  entry.mtime        = fstat.fMtime;
+  entry.treenames[0] = treenames[0];
+  entry.treenames[1] = treenames[1];
+  entry.nentries     = ftree->GetEntries();
+
+  // generally files will only have one meta data entry, but if they've
+  // been combined (i.e. "hadd") there might be more than one.
+  int nmeta = mtree->GetEntries();
+  double potsum = 0;
+  entry.jobs.clear();
+  bsim::DkMeta* dkmeta = new bsim::DkMeta;
+  mtree->SetBranchAddress("dkmeta",&dkmeta);
+  for (int imeta = 0; imeta < nmeta; ++imeta ) {
+    mtree->GetEntry(imeta);
+    double potentry = dkmeta->pots;
+    potsum += potentry;
+    entry.jobs.push_back(dkmeta->job);
+  }
+  delete dkmeta;
+  entry.pots = potsum;
+
+  fEntries[path] = entry;
+  fChanged = true;
+}
+
+//___________________________________________________________________________
+GDk2NuFluxDecayCache::GDk2NuFluxDecayCache(Long64_t first, Long64_t end,
+                                           double maxbytes)
+  : fFirstEntry(first), fMaxBytes(maxbytes), fNCached(0)
+{
+  Rec empty;
+  std::memset(&empty,0,sizeof(empty));
+  empty.imu = -2;
+  fRecs.resize(end-first,empty);
+}
+
+//___________________________________________________________________________
+bool GDk2NuFluxDecayCache::Get(Long64_t ientry, bsim::Dk2Nu& dk2nu,
+                               double& t_dk) const
+{
+  const Rec& rec = fRecs[ientry-fFirstEntry];
+  if ( rec.imu == -2 ) return false;
+
+  bsim::Decay& decay = dk2nu.decay;
+  decay.vx     = rec.vx;
+  decay.vy     = rec.vy;
+  decay.vz     = rec.vz;
+  decay.pdpx   = rec.pdpx;
+  decay.pdpy   = rec.pdpy;
+  decay.pdpz   = rec.pdpz;
+  decay.necm   = rec.necm;
+  decay.nimpwt = rec.nimpwt;
+  decay.ptype  = rec.ptype;
+  decay.ntype  = rec.ntype;
+  if ( rec.imu >= 0 ) {
+    const MuRec& mu = fMuRecs[rec.imu];
+    decay.ppdxdz   = mu.ppdxdz;
+    decay.ppdydz   = mu.ppdydz;
+    decay.pppz     = mu.pppz;
+    decay.ppenergy = mu.ppenergy;
+    decay.muparpx  = mu.muparpx;
+    decay.muparpy  = mu.muparpy;
+    decay.muparpz  = mu.muparpz;
+    decay.mupare   = mu.mupare;
+  }
+  dk2nu.job    = rec.job;
+  dk2nu.potnum = rec.potnum;
+  t_dk         = rec.tdk;
+  return true;
+}
+
+//___________________________________________________________________________
+void GDk2NuFluxDecayCache::Put(Long64_t ientry, const bsim::Dk2Nu& dk2nu,
+                               double t_dk)
+{
+  Rec& rec = fRecs[ientry-fFirstEntry];
+  if ( rec.imu != -2 ) return;
+
+  const bsim::Decay& decay = dk2nu.decay;
+  bool ismuon = ( decay.ptype == kPdgMuon || decay.ptype == kPdgAntiMuon );
+  if ( ismuon ) {
+    // out of room, this one will be read from file every time
+    if ( this->NBytes() + sizeof(MuRec) > fMaxBytes ) return;
+    MuRec mu;
+    mu.ppdxdz   = decay.ppdxdz;
+    mu.ppdydz   = decay.ppdydz;
+    mu.pppz     = decay.pppz;
+    mu.ppenergy = decay.ppenergy;
+    mu.muparpx  = decay.muparpx;
+    mu.muparpy  = decay.muparpy;
+    mu.muparpz  = decay.muparpz;
+    mu.mupare   = decay.mupare;
+    fMuRecs.push_back(mu);
+  }
+
+  rec.vx     = decay.vx;
+  rec.vy     = decay.vy;
+  rec.vz     = decay.vz;
+  rec.pdpx   = decay.pdpx;
+  rec.pdpy   = decay.pdpy;
+  rec.pdpz   = decay.pdpz;
+  rec.necm   = decay.necm;
+  rec.nimpwt = decay.nimpwt;
+  rec.tdk    = t_dk;
+  rec.ptype  = decay.ptype;
+  rec.ntype  = decay.ntype;
+  rec.job    = dk2nu.job;
+  rec.potnum = dk2nu.potnum;
+  rec.imu    = ( ismuon ) ? (Int_t)fMuRecs.size() - 1 : -1;
+  ++fNCached;
+}
+
 //___________________________________________________________________________
 
 std::vector<double> GDk2NuFluxXMLHelper::GetDoubleVector(std::string str)
@@ -1487,6 +3355,53 @@ void GDk2NuFluxXMLHelper::ParseParamSet(xmlDocPtr& xml_doc, xmlNodePtr& xml_pset
       fGDk2NuFlux->SetEntryReuse(nreuse);
       SLOG("GDk2NuFlux", pINFO) << "set entry reuse = " << nreuse;
 
+    } else if ( pname == "readprofile" ) {
+      fGDk2NuFlux->SetReadProfile(pval);
+      SLOG("GDk2NuFlux", pINFO) << "set read profile = \"" << pval << "\"";
+
+    } else if ( pname == "scanthreads" ) {
+      int nthreads = 1;
+      std::vector<long int> v = GetIntVector(pval);
+      if ( v.size() > 0 ) nthreads = v[0];
+      fGDk2NuFlux->SetMaxWgtScanThreads(nthreads);
+      SLOG("GDk2NuFlux", pINFO) << "set max weight scan threads = " << nthreads;
+
+    } else if ( pname == "maxwgtcache" ) {
+      fGDk2NuFlux->SetMaxWgtCache(pval);
+      SLOG("GDk2NuFlux", pINFO) << "set max weight cache = \"" << pval << "\"";
+
+    } else if ( pname == "filecatalog" ) {
+      fGDk2NuFlux->SetFileCatalog(pval);
+      SLOG("GDk2NuFlux", pINFO) << "set file catalog = \"" << pval << "\"";
+
+    } else if ( pname == "entryindex" ) {
+      fGDk2NuFlux->SetEntryIndexDir(pval);
+      SLOG("GDk2NuFlux", pINFO) << "set entry index dir = \"" << pval << "\"";
+
+    } else if ( pname == "entryselection" ) {
+      // "weighted" or "sequential"
+      bool byweight = ( pval == "weighted" );
+      if ( ! byweight && pval != "sequential" ) {
+        SLOG("GDk2NuFlux", pWARN)
+          << "  unknown entryselection \"" << pval << "\", using sequential";
+      }
+      fGDk2NuFlux->SetWeightedEntrySelection(byweight);
+      SLOG("GDk2NuFlux", pINFO) << "set entry selection = \"" << pval << "\"";
+
+    } else if ( pname == "decaycache" ) {
+      double maxmb = 0;
+      std::vector<double> v = GetDoubleVector(pval);
+      if ( v.size() > 0 ) maxmb = v[0];
+      fGDk2NuFlux->SetDecayCacheSize(maxmb);
+      SLOG("GDk2NuFlux", pINFO) << "set decay cache size = " << maxmb << " MB";
+
+    } else if ( pname == "prefetch" ) {
+      int depth = 0;
+      std::vector<long int> v = GetIntVector(pval);
+      if ( v.size() > 0 ) depth = v[0];
+      fGDk2NuFlux->SetPrefetchDepth(depth);
+      SLOG("GDk2NuFlux", pINFO) << "set prefetch depth = " << depth;
+
     } else {
       SLOG("GDk2NuFlux", pWARN)
         << "  NOT HANDLED: pname \"" << pname 
@@ -42,11 +42,45 @@ namespace bsim {
   class Dk2Nu;
   class DkMeta;
   class NuChoice;
+  class AncChainReader;
 }
 
 namespace genie {
 namespace flux  {
 
+class GDk2NuFluxPrefetch;
+class GDk2NuFluxWgtScan;
+class GDk2NuFluxDecayCache;
+
+// Flux neutrinos from GDk2NuFlux::GenerateNextBatch(), one array per
+// quantity; the 4-vectors are 4 arrays each, index 0-3 = x,y,z,t or
+// px,py,pz,E (beam coords in cm, user coords in the user's units)
+class GDk2NuFluxBatch {
+public:
+  GDk2NuFluxBatch() : n(0) { }
+  void Resize(size_t nmax) {
+    n = 0;
+    pdgNu.resize(nmax);
+    entry.resize(nmax);
+    wgt.resize(nmax);
+    for (int j = 0; j < 4; ++j) {
+      p4NuBeam[j].resize(nmax);
+      x4NuBeam[j].resize(nmax);
+      p4NuUser[j].resize(nmax);
+      x4NuUser[j].resize(nmax);
+    }
+  }
+
+  size_t                n;            ///< # of neutrinos in the batch
+  std::vector<int>      pdgNu;        ///< neutrino flavor
+  std::vector<Long64_t> entry;        ///< flux ntuple entry it came from
+  std::vector<double>   wgt;          ///< Weight(), =1 if unweighted
+  std::vector<double>   p4NuBeam[4];  ///< 4-momentum, beam coord
+  std::vector<double>   x4NuBeam[4];  ///< 4-position, beam coord
+  std::vector<double>   p4NuUser[4];  ///< 4-momentum, user coord
+  std::vector<double>   x4NuUser[4];  ///< 4-position, user coord
+};
+
 class GDk2NuFlux: public GFluxI {
 
 public :
@@ -68,6 +102,18 @@ public :
   void                   Clear            (Option_t * opt);
   void                   GenerateWeighted (bool gen_weighted);
 
+  // up to n flux neutrinos at once, the same ones n calls to GenerateNext()
+  // would give (fewer at End()); a weighted call whose entry had an
+  // unwanted flavor gives no neutrino, rather than returning false.  The
+  // per neutrino arithmetic (direction, beam->user transforms, tilt
+  // weight, time, MoveToZ0) is done as loops over the batch.  The current
+  // neutrino afterwards is the last one tried.  Returns the number made;
+  // GetBatch() has them until the next call.  (Unweighted, each try's
+  // weight is worked out, and the try accepted or not, before the next
+  // one, so random numbers are drawn in the same order as GenerateNext().)
+  long int               GenerateNextBatch(long int n);
+  const GDk2NuFluxBatch& GetBatch(void) const { return *fBatch; }
+
   // Methods specific to this flux driver,
   // for configuration/initialization of the flux & event generation drivers 
   // and and for passing-through flux information (e.g. neutrino parent decay
@@ -78,7 +124,7 @@ public :
   // information about or actions on current entry
   //
   const bsim::NuChoice &  GetNuChoice(void) { return *fCurNuChoice; };
-  const bsim::Dk2Nu &     GetDk2Nu(void)    { return *fCurDk2Nu; };
+  const bsim::Dk2Nu &     GetDk2Nu(void)    { LoadFullDk2Nu(); return *fCurDk2Nu; };
   const bsim::DkMeta &    GetDkMeta(void)   { LoadDkMeta(); return *fCurDkMeta; };
   
   Long64_t GetEntryNumber() { return fIEntry; }   ///< index in chain
@@ -107,10 +153,77 @@ public :
 
   void      SetTreeNames(string fname = "dk2nuTree", string mname = "dkmetaTree") { fTreeNames[0] = fname; fTreeNames[1] = mname; }
 
+  // which parts of each dk2nu entry are read from file:
+  //   "full"  - everything (default)
+  //   "decay" - only what is needed to generate rays (job, potnum, decay,
+  //             flagbits and the ancestor start times); the rest of the
+  //             entry is read if GetDk2Nu() or PrintCurrent() asks for it
+  // any further words are the names of extra branches to read, e.g.
+  //   "decay nuray*"
+  void      SetReadProfile(string profile = "full");
+  std::string GetReadProfile() const { return fReadProfile; }
+
+  // read entries ahead of use in a background thread, keeping up to
+  // "depth" of them decoded in memory (0 = read each entry when needed).
+  // The entries used, and so the events generated, are the same either way.
+  void      SetPrefetchDepth(int depth = 0);
+  int       GetPrefetchDepth() const { return fPrefetchDepth; }
+
+  // keep what generating rays needs from each entry (decay, job, potnum
+  // and the decay time) in memory as it is first read, so that further
+  // cycles through the files are served from memory rather than read and
+  // decompressed again; the rest of an entry is still read if GetDk2Nu()
+  // asks for it.  This takes about 100 bytes per entry; if the files need
+  // more than "maxmb" megabytes they are read as usual (0 = off).
+  void      SetDecayCacheSize(double maxmb = 0);
+  double    GetDecayCacheSize() const { return fDecayCacheMB; }
+
+  // keep an index of each entry's neutrino flavor (and an upper bound on
+  // its energy), so that entries of flavors not in SetFluxParticles() are
+  // skipped without being read; they still count towards UsedPOTs() and
+  // NFluxNeutrinos() as if they'd been read and rejected.  The index of
+  // each file is built once and saved in this directory ("" = no index).
+  // Must be set before LoadBeamSimData().
+  void      SetEntryIndexDir(string dir = "") { fEntryIndexDir = dir; }
+
+  // for unweighted generation, pick entries at random in proportion to an
+  // upper bound on their weight at the flux window, rather than in file
+  // order accepting each in proportion to its weight against the overall
+  // maximum.  Far fewer entries are read for nothing; the neutrinos
+  // generated follow the same distribution and UsedPOTs() keeps the same
+  // normalization.  The bounds take one pass through the files (in place
+  // of the max weight scan); entries are then read in random order, so
+  // SetPrefetchDepth() has no effect.  Set before LoadBeamSimData().
+  void      SetWeightedEntrySelection(bool byweight = false) { fPickByWeight = byweight; }
+  bool      GetWeightedEntrySelection() const { return fPickByWeight; }
+
+  // keep a summary of each flux file (entries, POTs, metadata jobs and
+  // tree names) in this text file, checked against the file's size and
+  // modification time.  Files found there aren't opened when the chains
+  // are set up, only when entries are read from them; the rest are
+  // opened as usual and added to the catalog ("" = no catalog).
+  // Must be set before LoadBeamSimData().
+  void      SetFileCatalog(string fname = "") { fFileCatalog = fname; }
+
   void      LoadBeamSimData(std::vector<string> filenames, string det_loc);     ///< load root flux ntuple files and config
   void      LoadBeamSimData(std::set<string>    filenames, string det_loc);     ///< load root flux ntuple files and config
   void      LoadBeamSimData(string filename, string det_loc);     ///< older (obsolete) single file version
 
+  // A copy of this (loaded) driver for one of nthreads generation
+  // threads.  It has the same configuration (flux window, beam transform,
+  // max weight and energy, flavors, files, ...) but a chain and current
+  // entry of its own, and takes only its share of the entries,
+  //   [ithread*N/nthreads, (ithread+1)*N/nthreads)
+  // cycling through them as SetNumOfCycles() says.  Its random numbers
+  // don't come from RandomGen but are a function of (seed, cycle, entry,
+  // use of the entry), so each entry gives the same neutrinos whichever
+  // clone has it: the combined output doesn't depend on the number of
+  // threads.  Clones take entries in order (see SetWeightedEntrySelection)
+  // and may be used concurrently; the caller deletes them.  If the max
+  // weight isn't known yet it is scanned for first (on this driver); 0 is
+  // returned if it can't be found.
+  GDk2NuFlux* CloneForThread(int ithread, int nthreads, UInt_t seed);
+
   bool      LoadConfig(string cfg);                               ///< load a named configuration
   void      SetFluxParticles(const PDGCodeList & particles);      ///< specify list of flux neutrino species
   void      SetMaxEnergy(double Ev);                              ///< specify maximum flx neutrino energy
@@ -126,6 +239,18 @@ public :
   void      SetMaxEFudge(double fudge = 1.05)                  ///< extra fudge factor in estimating maximum energy
             { fMaxEFudge = fudge; }
 
+  // The max weight scan can be spread over threads, each reading its own
+  // range of entries with its own random numbers.  The result does not
+  // depend on the number of threads (but differs from the 1 thread scan,
+  // which walks through the entries the way generation does).
+  void      SetMaxWgtScanThreads(int nthreads = 1)             ///< # of threads for ScanForMaxWeight()
+            { fMaxWgtThreads = (nthreads > 1) ? nthreads : 1; }
+  // Results of the scan are saved in this (text) file, keyed by the file
+  // list (with sizes and times), flux window, flavors, units and scan
+  // size; a later job with the same key takes the result from the file
+  // rather than scanning again.  "" turns this off.
+  void      SetMaxWgtCache(string fname = "") { fMaxWgtCache = fname; }
+
   void      SetApplyWindowTiltWeight(bool apply = true)           ///< apply wgt due to tilt of flux window relative to beam                                   
             { fApplyTiltWeight = apply; }
 
@@ -187,13 +312,36 @@ private:
   // Private methods
   //
   bool GenerateNext_weighted (void);
+  bool GenerateNextEntry     (void);
   void Initialize            (void);
   void SetDefaults           (void);
   void CleanUp               (void);
   void ResetCurrent          (void);
-  void AddFile               (TTree* fluxtree, TTree* metatree, string fname);
+  void AddFile               (string fname, Long64_t nentries, double pots,
+                              const std::vector<int>& jobs);
   void CalcEffPOTsPerNu      (void);
   void LoadDkMeta            (void);
+  void ApplyReadProfile      (TChain* chain) const;
+  void LoadFullDk2Nu         (void);
+  void StartPrefetch         (void);
+  void StopPrefetch          (void);
+  double FluxRndm            (int idraw);
+  void RestoreAncestors      (bsim::Dk2Nu* dk2nu);
+  void StartDecayCache       (void);
+  void StopDecayCache        (void);
+  void ScanForMaxWeightThreaded(double& wgtmax, double& enumax);
+  std::vector<std::string> MaxWgtScanKey(void);
+  bool ReadMaxWgtCache       (const std::vector<std::string>& key,
+                              double& wgtmax, double& enumax);
+  void WriteMaxWgtCache      (const std::vector<std::string>& key,
+                              double wgtmax, double enumax);
+  void LoadEntryIndex        (void);
+  bool ReadEntryIndex        (const std::string& fname, Long64_t nentries);
+  void BuildEntryIndex       (const std::string& fname, Long64_t nentries);
+  void UpdateEntryUsable     (void);
+  void ClearPickTable        (void);
+  void BuildPickTable        (void);
+  Long64_t PickEntry         (void);
 
   // Private data members
   //
@@ -208,24 +356,61 @@ private:
   std::string fTreeNames[2];      ///< pair of names "dk2nuTree", "dkmetaTree"
   TChain*   fNuFluxTree;          ///< TTree // REF ONLY!
   TChain*   fNuMetaTree;          ///< TTree // REF ONLY!
+  TChain*   fNuAncTree;           ///< shared ancestor chains, if the files have them
+  bsim::AncChainReader* fAncReader; ///< puts them back into entries
 
   bsim::Dk2Nu*     fCurDk2Nu;
+  bsim::Dk2Nu*     fChainDk2Nu;   ///< where fNuFluxTree reads entries to
   bsim::DkMeta*    fCurDkMeta;
   bsim::NuChoice*  fCurNuChoice;
+  GDk2NuFluxBatch* fBatch;        ///< neutrinos from GenerateNextBatch()
 
   int       fNFiles;              ///< number of files in chain
   Long64_t  fNEntries;            ///< number of flux ntuple entries
   Long64_t  fIEntry;              ///< current flux ntuple entry
+  Long64_t  fFirstEntry;          ///< first entry this driver takes
+  Long64_t  fEndEntry;            ///< one past the last entry it takes
+  bool      fCounterRng;          ///< random numbers from FluxRndm's counters
+  UInt_t    fRngSeed;             ///< seed for those
+  int       fNTdkZeroMsg;         ///< # of t_dk=0 notices left to print
   Long64_t  fNuTot;               ///< cummulative # of entries (=fNEntries)
   Long64_t  fFilePOTs;            ///< # of protons-on-target represented by all files
 
   std:: map<int,int>  fJobToMetaIndex;  ///< quick lookup from job# to meta chain
+  int       fNMetaEntries;        ///< # of metadata entries in the meta chain
+  string    fFileCatalog;         ///< summaries of the flux files ("" = none)
+
+  std::string fReadProfile;       ///< which branches of dk2nu entries to read
+  bool      fReadDecayOnly;       ///< read profile leaves out part of the entry
+  bool      fCurDk2NuFull;        ///< all of the current entry has been read
+
+  int                  fPrefetchDepth; ///< # of entries to read ahead
+  GDk2NuFluxPrefetch*  fPrefetch;      ///< background reader, if running
+
+  double                 fDecayCacheMB; ///< memory allowed for fDecayCache (0 = none)
+  GDk2NuFluxDecayCache*  fDecayCache;   ///< entries kept in memory, if any
+  double                 fCurTdk;       ///< decay time of the current entry
+
+  string                fEntryIndexDir; ///< where entry indices are kept ("" = none)
+  std::vector<Short_t>  fEntryNType;    ///< neutrino flavor of each entry
+  std::vector<Float_t>  fEntryEMax;     ///< upper bound on each entry's E_nu
+  std::vector<bool>     fEntryUsable;   ///< flavor is in fPdgCList (empty = no index)
+  Long64_t              fNEntryUsable;  ///< # of usable entries
+
+  bool                  fPickByWeight;  ///< pick entries by weight bound
+  std::vector<Float_t>  fPickWgtMax;    ///< bound on each entry's weight (empty = not built)
+  std::vector<Float_t>  fPickProb;      ///< alias table: chance to keep a pick
+  std::vector<Int_t>    fPickAlias;     ///< alias table: entry taken otherwise
+  double                fPickWgtMean;   ///< mean of fPickWgtMax over all entries
+  Long64_t              fNPicked;       ///< # of entries picked this cycle
 
   double    fWeight;              ///< current neutrino weight, =1 if generating unweighted entries
   double    fMaxWeight;           ///< max flux neutrino weight in input file
   double    fMaxWgtFudge;         ///< fudge factor for estimating max wgt
   long int  fMaxWgtEntries;       ///< # of entries in estimating max wgt
   double    fMaxEFudge;           ///< fudge factor for estmating max enu (0=> use fixed 120GeV)
+  int       fMaxWgtThreads;       ///< # of threads in estimating max wgt
+  string    fMaxWgtCache;         ///< file of saved max wgt scans ("" = none)
 
   long int  fNCycles;             ///< # times to cycle through the flux ntuple
   long int  fICycle;              ///< current file cycle
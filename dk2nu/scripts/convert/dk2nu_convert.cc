@@ -0,0 +1,76 @@
+/// Compiled driver for the convert_*.C macros
+///
+///   dk2nu_convert <g4lbne|g4minerva|flugg> input.root [options]
+///      -j nthreads    worker threads converting entries (default 1)
+///      -n maxentries  stop after this many entries
+///      -d moddump     print every moddump-th entry
+///      -J jobnum      job number to record (default 42)
+///      -l locfile     locations file (g4lbne only)
+///      -L inputloc    "MINOS" or "NOvA" cross check locations (flugg only)
+///      -a 0|1         write ancestor chains once per proton, in a
+///                     dkancTree (see tree/AncChains.h; default 0)
+///
+/// The macros are compiled in as-is, so the output, the cross check
+/// summary (obs_frac_diff_max) and the pots estimate are those of the
+/// interpreted macros, whatever the number of threads.
+///==========================================================================
+
+#include <cstdlib>
+#include <cstring>
+
+#include "convert/g4lbne/convert_g4lbne.C"
+#include "convert/g4minerva/convert_g4minerva.C"
+#include "convert/flugg/convert_flugg.C"
+
+static void usage(const char* prog)
+{
+  std::cerr << "usage: " << prog << " <g4lbne|g4minerva|flugg> input.root"
+            << " [-j nthreads] [-n maxentries] [-d moddump] [-J jobnum]"
+            << " [-l locfile] [-L inputloc] [-a 0|1]" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  if ( argc < 3 ) { usage(argv[0]); return 1; }
+
+  std::string format   = argv[1];
+  std::string ifname   = argv[2];
+  int         nthreads = 1;
+  Long64_t    maxent   = -1;
+  Long64_t    moddump  = -1;
+  int         jobnum   = 42;
+  std::string locfile  = "${DK2NU}/etc/LBNElocations.txt";
+  std::string inputloc = "MINOS";
+
+  for (int i = 3; i < argc; ++i ) {
+    if ( i+1 >= argc || argv[i][0] != '-' || std::strlen(argv[i]) != 2 ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const char* val = argv[++i];
+    switch ( argv[i-1][1] ) {
+    case 'j': nthreads = std::atoi(val);  break;
+    case 'n': maxent   = std::atoll(val); break;
+    case 'd': moddump  = std::atoll(val); break;
+    case 'J': jobnum   = std::atoi(val);  break;
+    case 'l': locfile  = val;             break;
+    case 'L': inputloc = val;             break;
+    case 'a': shareAncestors = ( std::atoi(val) != 0 ); break;
+    default:  usage(argv[0]); return 1;
+    }
+  }
+
+  if      ( format == "g4lbne" )
+    convert_g4lbne(ifname,jobnum,locfile,maxent,moddump,nthreads);
+  else if ( format == "g4minerva" )
+    convert_g4minerva(ifname,jobnum,maxent,moddump,nthreads);
+  else if ( format == "flugg" )
+    convert_flugg(ifname,jobnum,inputloc,maxent,moddump,nthreads);
+  else {
+    std::cerr << "unknown input format \"" << format << "\"" << std::endl;
+    usage(argv[0]);
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,321 @@
+/// Compiled, multi-threaded flux histograms from dk2nu files
+///
+///   dk2nu_fluxhist [options] input.root|@filelist ...
+///      -o outfile     output ROOT file (default dk2nu_fluxhist.root)
+///      -l locfile     locations file (default: those in the first dkmeta)
+///      -j nthreads    worker threads (default: number of cores)
+///      -b n,lo,hi     uniform energy binning in GeV (default 200,0,50)
+///      -B e0,e1,...   variable energy bin edges in GeV (overrides -b)
+///      -n maxentries  stop after this many entries
+///      -t tree        dk2nu tree name (default "dk2nuTree")
+///      -m tree        dkmeta tree name (default "dkmetaTree")
+///
+/// For every location, neutrino flavor and parent species the neutrino
+/// energy at the location is histogrammed with weight nimpwt * wgt_xy
+/// from bsim::calcEnuWgt, i.e. the same numbers calcLocationWeights
+/// stores in nuray.  The histograms are normalized to nu / m^2 / POT per
+/// bin using the pots summed over the dkmeta entries.  The "random decay"
+/// pseudo-location is skipped, as calcLocationWeights does.  Input names
+/// may be wildcards (as for TChain::Add); "@file" reads names from a
+/// file, one per line.
+///
+/// Only the decay block of each entry is read, on the calling thread
+/// (ROOT I/O is not thread-safe).  Blocks of decays are handed to the
+/// worker threads, each of which fills bin arrays of its own; these are
+/// added together into the output histograms at the end, so the workers
+/// never share anything they write.  As the location loop dominates, the
+/// rate goes up nearly in proportion to the number of threads until
+/// reading the decays becomes the limit.
+///==========================================================================
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TChain.h"
+#include "TDirectory.h"
+#include "TH1D.h"
+#include "TParameter.h"
+#include "TStopwatch.h"
+#include "TMath.h"
+
+// dk2nu headers
+#include "tree/dk2nu.h"
+#include "tree/dkmeta.h"
+#include "tree/readWeightLocations.h"
+#include "tree/calcLocationWeights.h"
+
+#include "flux/common_flux.C"
+
+namespace {
+
+  // neutrino flavors and parent species given histograms of their own;
+  // other parents go to "other", other flavors are counted but skipped
+  const int    kNFlav = 6;
+  const int    kFlavPdg[kNFlav]   = { 14, -14, 12, -12, 16, -16 };
+  const char*  kFlavName[kNFlav]  = { "numu", "numubar", "nue", "nuebar",
+                                      "nutau", "nutaubar" };
+  const int    kNPar = 8;
+  const int    kParPdg[kNPar-1]   = { 211, -211, 321, -321, 130, 13, -13 };
+  const char*  kParName[kNPar]    = { "pip", "pim", "kp", "km", "k0l",
+                                      "mup", "mum", "other" };
+
+  int flavorIndex(int pdg)
+  {
+    for (int i = 0; i < kNFlav; ++i) if ( kFlavPdg[i] == pdg ) return i;
+    return -1;
+  }
+
+  int parentIndex(int pdg)
+  {
+    for (int i = 0; i < kNPar-1; ++i) if ( kParPdg[i] == pdg ) return i;
+    return kNPar-1;
+  }
+
+  /// one worker's sums: [location][flavor][parent][bin]
+  class FluxSums
+  {
+  public:
+    FluxSums(const std::vector<double>& xloc, const std::vector<double>& yloc,
+             const std::vector<double>& zloc, const Binning& ebins)
+      : x(xloc), y(yloc), z(zloc), binning(ebins), nb(ebins.n+2),
+        sumw(x.size()*kNFlav*kNPar*nb,0.), sumw2(sumw.size(),0.),
+        nused(0), nskipped(0), nstatus(0), enu(x.size()), wgt(x.size()) { }
+    size_t index(size_t iloc, int iflav, int ipar, int ibin) const
+      { return ( ( iloc*kNFlav + iflav )*kNPar + ipar )*nb + ibin; }
+
+    void fill(const bsim::Decay& decay)
+    {
+      int iflav = flavorIndex(decay.ntype);
+      if ( iflav < 0 ) { ++nskipped; return; }
+      int ipar  = parentIndex(decay.ptype);
+      // all locations at once: the parent kinematics are done only once
+      const size_t nloc = x.size();
+      if ( bsim::calcEnuWgt(decay,nloc,&x[0],&y[0],&z[0],&enu[0],&wgt[0]) )
+        ++nstatus;
+      for (size_t iloc = 0; iloc < nloc; ++iloc) {
+        double w  = decay.nimpwt * wgt[iloc];
+        size_t ix = index(iloc,iflav,ipar,binning.bin(enu[iloc]));
+        sumw[ix]  += w;
+        sumw2[ix] += w*w;
+      }
+      ++nused;
+    }
+
+    const std::vector<double>& x;
+    const std::vector<double>& y;
+    const std::vector<double>& z;
+    const Binning&             binning;
+    size_t                     nb;
+    std::vector<double>        sumw, sumw2;
+    Long64_t                   nused, nskipped, nstatus;
+  private:
+    std::vector<double>        enu, wgt;
+  };
+
+  void usage(const char* prog)
+  {
+    std::cerr << "usage: " << prog << " [-o outfile] [-l locfile]"
+              << " [-j nthreads] [-b n,lo,hi | -B e0,e1,...]"
+              << " [-n maxentries] [-t tree] [-m metatree]"
+              << " input.root|@filelist ..." << std::endl;
+  }
+
+  /// location names made fit for a TDirectory name
+  std::string dirName(const std::string& name, size_t iloc)
+  {
+    std::string d;
+    for (size_t i = 0; i < name.size(); ++i) {
+      char c = name[i];
+      d += ( isalnum((unsigned char)c) || c == '_' || c == '-' ) ? c : '_';
+    }
+    if ( d.empty() ) {
+      std::ostringstream os;
+      os << "loc" << iloc;
+      d = os.str();
+    }
+    return d;
+  }
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  std::string ofname    = "dk2nu_fluxhist.root";
+  std::string locfile   = "";
+  int         nthreads  = std::thread::hardware_concurrency();
+  std::string binspec   = "200,0,50";
+  std::string edgespec  = "";
+  Long64_t    maxent    = -1;
+  std::string treename  = "dk2nuTree";
+  std::string metaname  = "dkmetaTree";
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; ++i ) {
+    if ( argv[i][0] != '-' ) { inputs.push_back(argv[i]); continue; }
+    if ( i+1 >= argc || std::strlen(argv[i]) != 2 ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const char* val = argv[++i];
+    switch ( argv[i-1][1] ) {
+    case 'o': ofname   = val;             break;
+    case 'l': locfile  = val;             break;
+    case 'j': nthreads = std::atoi(val);  break;
+    case 'b': binspec  = val;             break;
+    case 'B': edgespec = val;             break;
+    case 'n': maxent   = std::atoll(val); break;
+    case 't': treename = val;             break;
+    case 'm': metaname = val;             break;
+    default:  usage(argv[0]); return 1;
+    }
+  }
+  if ( inputs.empty() ) { usage(argv[0]); return 1; }
+  if ( nthreads < 1 ) nthreads = 1;
+
+  // energy binning
+  Binning binning;
+  if ( ! binning.set(binspec,edgespec) ) {
+    std::cerr << "bad binning \"" << ( edgespec != "" ? edgespec : binspec )
+              << "\"" << std::endl;
+    return 1;
+  }
+
+  // the input files; pots, and the default locations, from the metadata
+  TChain* dk2nuChain  = new TChain(treename.c_str());
+  TChain* dkmetaChain = new TChain(metaname.c_str());
+  if ( ! AddFluxInputs(inputs,dk2nuChain,dkmetaChain) ) return 1;
+  std::vector<bsim::Location> locations;
+  double pots = ReadFluxMeta(dkmetaChain,locations);
+  if ( locfile != "" ) {
+    locations.clear();
+    bsim::readWeightLocations(locfile,locations);
+    DropRandomDecay(locations);
+  }
+  if ( locations.empty() ) {
+    std::cerr << "no locations (-l locfile or dkmeta locations)" << std::endl;
+    return 1;
+  }
+  if ( pots <= 0 ) {
+    std::cerr << "no pots in the " << metaname << " entries; "
+              << "histograms are left per entry" << std::endl;
+  }
+
+  const size_t nloc = locations.size();
+  std::vector<double> x(nloc), y(nloc), z(nloc);
+  for (size_t iloc = 0; iloc < nloc; ++iloc) {
+    x[iloc] = locations[iloc].x;
+    y[iloc] = locations[iloc].y;
+    z[iloc] = locations[iloc].z;
+  }
+
+  Long64_t nentries = dk2nuChain->GetEntries();
+  Long64_t nread    = ( maxent >= 0 && maxent < nentries ) ? maxent : nentries;
+  std::cout << "dk2nu_fluxhist: " << nentries << " entries, " << pots
+            << " pots, " << nloc << " locations, " << nthreads
+            << " threads" << std::endl;
+
+  std::vector<FluxSums*> sums(nthreads);
+  for (int i = 0; i < nthreads; ++i)
+    sums[i] = new FluxSums(x,y,z,binning);
+
+  TStopwatch timer;
+  timer.Start();
+  nread = DecayLoop(dk2nuChain,nread,sums);
+  timer.Stop();
+
+  // add up the workers' sums
+  FluxSums& total = *sums[0];
+  for (int i = 1; i < nthreads; ++i) {
+    for (size_t k = 0; k < total.sumw.size(); ++k) {
+      total.sumw[k]  += sums[i]->sumw[k];
+      total.sumw2[k] += sums[i]->sumw2[k];
+    }
+    total.nused    += sums[i]->nused;
+    total.nskipped += sums[i]->nskipped;
+    total.nstatus  += sums[i]->nstatus;
+  }
+
+  // with fewer entries read than there are, use their share of the pots
+  double usedpots = pots;
+  if ( nread < nentries && nentries > 0 ) {
+    usedpots = pots * double(nread) / double(nentries);
+    std::cerr << "read " << nread << " of " << nentries << " entries; "
+              << "normalizing to " << usedpots << " of " << pots << " pots"
+              << std::endl;
+  }
+  // probability to hit the disk -> per m^2, per pot
+  double scale = kFluxPerM2;
+  if ( usedpots > 0 ) scale /= usedpots;
+
+  TFile* ofile = TFile::Open(ofname.c_str(),"RECREATE");
+  if ( ! ofile || ! ofile->IsOpen() ) {
+    std::cerr << "can't write " << ofname << std::endl;
+    return 1;
+  }
+  TParameter<double>("pots",usedpots).Write();
+
+  for (size_t iloc = 0; iloc < nloc; ++iloc) {
+    const bsim::Location& loc = locations[iloc];
+    TDirectory* dir = ofile->mkdir(dirName(loc.name,iloc).c_str(),
+                                   loc.AsString().c_str());
+    dir->cd();
+    for (int iflav = 0; iflav < kNFlav; ++iflav) {
+      std::vector<TH1D*> hpar(kNPar+1);
+      for (int ipar = 0; ipar <= kNPar; ++ipar) {
+        std::string hname = std::string("enu_") + kFlavName[iflav] + "_"
+                          + ( ipar < kNPar ? kParName[ipar] : "all" );
+        std::string htitle = std::string(kFlavName[iflav]) + " from "
+                           + ( ipar < kNPar ? kParName[ipar] : "all parents" )
+                           + " at " + loc.name
+                           + ";E_{#nu} (GeV);#nu / m^{2} / POT / bin";
+        if ( binning.uniform )
+          hpar[ipar] = new TH1D(hname.c_str(),htitle.c_str(),
+                                binning.n,binning.lo,binning.hi);
+        else
+          hpar[ipar] = new TH1D(hname.c_str(),htitle.c_str(),
+                                binning.n,&binning.edges[0]);
+        hpar[ipar]->Sumw2();
+      }
+      for (int ib = 0; ib <= binning.n+1; ++ib) {
+        double allw = 0, allw2 = 0;
+        for (int ipar = 0; ipar < kNPar; ++ipar) {
+          size_t ix = total.index(iloc,iflav,ipar,ib);
+          allw  += total.sumw[ix];
+          allw2 += total.sumw2[ix];
+          hpar[ipar]->SetBinContent(ib,scale*total.sumw[ix]);
+          hpar[ipar]->SetBinError(ib,scale*TMath::Sqrt(total.sumw2[ix]));
+        }
+        hpar[kNPar]->SetBinContent(ib,scale*allw);
+        hpar[kNPar]->SetBinError(ib,scale*TMath::Sqrt(allw2));
+      }
+      for (int ipar = 0; ipar <= kNPar; ++ipar) {
+        hpar[ipar]->SetEntries(double(total.nused));
+        hpar[ipar]->Write();
+        delete hpar[ipar];
+      }
+    }
+  }
+  ofile->Close();
+  delete ofile;
+
+  double rtime = timer.RealTime();
+  std::cout << "dk2nu_fluxhist: " << nread << " entries ("
+            << total.nskipped << " other flavors, "
+            << total.nstatus << " with calcEnuWgt status) in "
+            << std::setprecision(3) << rtime << " s";
+  if ( rtime > 0 )
+    std::cout << ", " << std::setprecision(4)
+              << double(nread) * double(nloc) / rtime
+              << " entry-locations/s";
+  std::cout << std::endl << "wrote " << ofname << std::endl;
+
+  for (int i = 0; i < nthreads; ++i) delete sums[i];
+  delete dk2nuChain;
+  delete dkmetaChain;
+  return 0;
+}
@@ -0,0 +1,243 @@
+/// Compiled, multi-threaded flux map (bsim::FluxMap) from dk2nu files
+///
+///   dk2nu_fluxmap -g nx,xlo,xhi,ny,ylo,yhi,nz,zlo,zhi [options]
+///                 input.root|@filelist ...
+///      -g grid        grid points along x, y, z and their extent
+///                     (beam coordinates, cm; required)
+///      -o outfile     output ROOT file (default dk2nu_fluxmap.root)
+///      -f pdg,...     neutrino flavors (default 14,-14,12,-12)
+///      -j nthreads    worker threads (default: number of cores)
+///      -b n,lo,hi     uniform energy binning in GeV (default 100,0,25)
+///      -B e0,e1,...   variable energy bin edges in GeV (overrides -b)
+///      -n maxentries  stop after this many entries
+///      -t tree        dk2nu tree name (default "dk2nuTree")
+///      -m tree        dkmeta tree name (default "dkmetaTree")
+///
+/// Every grid point is treated as a location: each decay is evaluated at
+/// all of them with one bsim::calcEnuWgt call, and nimpwt * wgt_xy is
+/// summed into the energy bin at that point.  The result, normalized to
+/// nu / m^2 / GeV / POT with the summed dkmeta pots, is written as the
+/// bsim::FluxMap "fluxmap"; FluxMap::Flux() then gives the flux at any
+/// point in the grid by interpolation.  The grid should be fine enough
+/// for the flux to be near linear between points; off axis it changes
+/// fastest across the beam.
+///
+/// Threading is as for dk2nu_fluxhist (see common_flux.C); each thread
+/// keeps sums of nflavors x npoints x nbins doubles.
+///==========================================================================
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TChain.h"
+#include "TParameter.h"
+#include "TStopwatch.h"
+
+// dk2nu headers
+#include "tree/dk2nu.h"
+#include "tree/dkmeta.h"
+#include "tree/calcLocationWeights.h"
+#include "tree/FluxMap.h"
+
+#include "flux/common_flux.C"
+
+namespace {
+
+  /// one worker's sums, indexed as bsim::FluxMap::flux
+  class MapSums
+  {
+  public:
+    MapSums(const bsim::FluxMap& fmap, const std::vector<double>& xpt,
+            const std::vector<double>& ypt, const std::vector<double>& zpt,
+            const Binning& ebins)
+      : map(fmap), x(xpt), y(ypt), z(zpt), binning(ebins),
+        sumw(fmap.flux.size(),0.), nused(0), nskipped(0), nstatus(0),
+        enu(x.size()), wgt(x.size()) { }
+
+    void fill(const bsim::Decay& decay)
+    {
+      int iflav = map.FlavorIndex(decay.ntype);
+      if ( iflav < 0 ) { ++nskipped; return; }
+      const size_t npt = x.size();
+      if ( bsim::calcEnuWgt(decay,npt,&x[0],&y[0],&z[0],&enu[0],&wgt[0]) )
+        ++nstatus;
+      for (size_t ipt = 0; ipt < npt; ++ipt) {
+        int ib = binning.bin(enu[ipt]);
+        if ( ib < 1 || ib > binning.n ) continue;
+        sumw[map.Index(iflav,ipt,ib-1)] += decay.nimpwt * wgt[ipt];
+      }
+      ++nused;
+    }
+
+    const bsim::FluxMap&       map;
+    const std::vector<double>& x;
+    const std::vector<double>& y;
+    const std::vector<double>& z;
+    const Binning&             binning;
+    std::vector<double>        sumw;
+    Long64_t                   nused, nskipped, nstatus;
+  private:
+    std::vector<double>        enu, wgt;
+  };
+
+  void usage(const char* prog)
+  {
+    std::cerr << "usage: " << prog << " -g nx,xlo,xhi,ny,ylo,yhi,nz,zlo,zhi"
+              << " [-o outfile] [-f pdg,...] [-j nthreads]"
+              << " [-b n,lo,hi | -B e0,e1,...] [-n maxentries]"
+              << " [-t tree] [-m metatree] input.root|@filelist ..."
+              << std::endl;
+  }
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  std::string ofname    = "dk2nu_fluxmap.root";
+  std::string gridspec  = "";
+  std::string flavspec  = "14,-14,12,-12";
+  int         nthreads  = std::thread::hardware_concurrency();
+  std::string binspec   = "100,0,25";
+  std::string edgespec  = "";
+  Long64_t    maxent    = -1;
+  std::string treename  = "dk2nuTree";
+  std::string metaname  = "dkmetaTree";
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; ++i ) {
+    if ( argv[i][0] != '-' ) { inputs.push_back(argv[i]); continue; }
+    if ( i+1 >= argc || std::strlen(argv[i]) != 2 ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const char* val = argv[++i];
+    switch ( argv[i-1][1] ) {
+    case 'o': ofname   = val;             break;
+    case 'g': gridspec = val;             break;
+    case 'f': flavspec = val;             break;
+    case 'j': nthreads = std::atoi(val);  break;
+    case 'b': binspec  = val;             break;
+    case 'B': edgespec = val;             break;
+    case 'n': maxent   = std::atoll(val); break;
+    case 't': treename = val;             break;
+    case 'm': metaname = val;             break;
+    default:  usage(argv[0]); return 1;
+    }
+  }
+  if ( inputs.empty() || gridspec == "" ) { usage(argv[0]); return 1; }
+  if ( nthreads < 1 ) nthreads = 1;
+
+  // energy binning, flavors and grid
+  Binning binning;
+  if ( ! binning.set(binspec,edgespec) ) {
+    std::cerr << "bad binning \"" << ( edgespec != "" ? edgespec : binspec )
+              << "\"" << std::endl;
+    return 1;
+  }
+  std::vector<double> fv = splitNumbers(flavspec);
+  std::vector<int> pdgs(fv.begin(),fv.end());
+  std::vector<double> g = splitNumbers(gridspec);
+  if ( pdgs.empty() || g.size() != 9 ||
+       g[0] < 1 || g[3] < 1 || g[6] < 1 ) {
+    std::cerr << "bad grid \"" << gridspec << "\" or flavors \""
+              << flavspec << "\"" << std::endl;
+    return 1;
+  }
+
+  bsim::FluxMap* fmap = new bsim::FluxMap;
+  fmap->SetGrid(int(g[0]),g[1],g[2],int(g[3]),g[4],g[5],int(g[6]),g[7],g[8],
+                binning.edges,pdgs);
+
+  const size_t npt = fmap->NPoints();
+  std::vector<double> x(npt), y(npt), z(npt);
+  for (size_t ipt = 0; ipt < npt; ++ipt) fmap->Point(ipt,x[ipt],y[ipt],z[ipt]);
+
+  // the input files; pots from the metadata
+  TChain* dk2nuChain  = new TChain(treename.c_str());
+  TChain* dkmetaChain = new TChain(metaname.c_str());
+  if ( ! AddFluxInputs(inputs,dk2nuChain,dkmetaChain) ) return 1;
+  std::vector<bsim::Location> locations;
+  double pots = ReadFluxMeta(dkmetaChain,locations);
+  if ( pots <= 0 ) {
+    std::cerr << "no pots in the " << metaname << " entries; "
+              << "the map is left per entry" << std::endl;
+  }
+
+  Long64_t nentries = dk2nuChain->GetEntries();
+  Long64_t nread    = ( maxent >= 0 && maxent < nentries ) ? maxent : nentries;
+  std::cout << "dk2nu_fluxmap: " << nentries << " entries, " << pots
+            << " pots, " << npt << " grid points, " << pdgs.size()
+            << " flavors, " << binning.n << " energy bins, " << nthreads
+            << " threads" << std::endl;
+
+  std::vector<MapSums*> sums(nthreads);
+  for (int i = 0; i < nthreads; ++i)
+    sums[i] = new MapSums(*fmap,x,y,z,binning);
+
+  TStopwatch timer;
+  timer.Start();
+  nread = DecayLoop(dk2nuChain,nread,sums);
+  timer.Stop();
+
+  // add up the workers' sums
+  MapSums& total = *sums[0];
+  for (int i = 1; i < nthreads; ++i) {
+    for (size_t k = 0; k < total.sumw.size(); ++k)
+      total.sumw[k] += sums[i]->sumw[k];
+    total.nused    += sums[i]->nused;
+    total.nskipped += sums[i]->nskipped;
+    total.nstatus  += sums[i]->nstatus;
+  }
+
+  // with fewer entries read than there are, use their share of the pots
+  double usedpots = pots;
+  if ( nread < nentries && nentries > 0 ) {
+    usedpots = pots * double(nread) / double(nentries);
+    std::cerr << "read " << nread << " of " << nentries << " entries; "
+              << "normalizing to " << usedpots << " of " << pots << " pots"
+              << std::endl;
+  }
+  double scale = kFluxPerM2;
+  if ( usedpots > 0 ) scale /= usedpots;
+
+  fmap->pots = usedpots;
+  const int ne = binning.n;
+  for (size_t k = 0; k < total.sumw.size(); ++k) {
+    int ie = k % ne;
+    double de = binning.edges[ie+1] - binning.edges[ie];
+    fmap->flux[k] = scale * total.sumw[k] / de;
+  }
+
+  TFile* ofile = TFile::Open(ofname.c_str(),"RECREATE");
+  if ( ! ofile || ! ofile->IsOpen() ) {
+    std::cerr << "can't write " << ofname << std::endl;
+    return 1;
+  }
+  ofile->WriteObject(fmap,"fluxmap");
+  TParameter<double>("pots",usedpots).Write();
+  ofile->Close();
+  delete ofile;
+
+  double rtime = timer.RealTime();
+  std::cout << "dk2nu_fluxmap: " << nread << " entries ("
+            << total.nskipped << " other flavors, "
+            << total.nstatus << " with calcEnuWgt status) in "
+            << std::setprecision(3) << rtime << " s";
+  if ( rtime > 0 )
+    std::cout << ", " << std::setprecision(4)
+              << double(nread) * double(npt) / rtime
+              << " entry-points/s";
+  std::cout << std::endl << *fmap << std::endl
+            << "wrote " << ofname << std::endl;
+
+  for (int i = 0; i < nthreads; ++i) delete sums[i];
+  delete fmap;
+  delete dk2nuChain;
+  delete dkmetaChain;
+  return 0;
+}
@@ -0,0 +1,467 @@
+/// Merge dk2nu files into fewer, read-optimized ones
+///
+///   dk2nu_repack [options] input.root|@filelist ...
+///      -o outfile     output file (default dk2nu_repack.root); with -e a
+///                     "%d" in the name numbers the files (else _NNN is
+///                     put in front of .root)
+///      -e n           at most n entries per output file (default: one file)
+///      -C algo:level  compression of the branches GDk2NuFlux reads with
+///                     its "decay" read profile (default zlib:1)
+///      -c algo:level  compression of the other branches (default lzma:6)
+///                     algo is zlib or lzma (or lz4 with ROOT 6)
+///      -b hot,cold    basket sizes in kB for those two sets (default 256,64)
+///      -F n           entries per cluster, i.e. auto flush (default 100000)
+///      -S split       split level of the dk2nu branch (default 99)
+///      -f pdg,...     order entries by flavor, in this order; others last
+///                     (one output file only: not with -e)
+///      -a 0|1         write ancestor chains once per proton (default 0)
+///      -J job         job number of the first output file, the next
+///                     ones counting up from it (default: first input's)
+///      -T n           entries read for the throughput report
+///                     (default 200000; 0 for none)
+///      -t tree        dk2nu tree name (default "dk2nuTree")
+///      -m tree        dkmeta tree name (default "dkmetaTree")
+///
+/// Each output file gets a job number of its own (-J, then counting up)
+/// and a single dkmeta entry: that of the first input, with the file's
+/// job and the pots of all the inputs shared out in proportion to the
+/// entries in the file.  Every dk2nu entry is given its file's job
+/// number.  So that (job, potnum) stays unique, the potnums of each input
+/// job after the first are shifted past those of the jobs before it.
+/// Inputs whose configuration strings or locations differ from the first
+/// one's are reported.  Inputs in the shared ancestor layout (see
+/// tree/AncChains.h) are read back into full entries first.  Sorting by
+/// flavor (-f) separates neutrinos of the same proton, so with -a 1 less
+/// of their ancestors is shared.
+///
+/// The throughput report reads the first n entries of the inputs and of
+/// the outputs, all of each entry and then just the "decay" branches,
+/// the way GDk2NuFlux does.  The inputs are read first, so the numbers
+/// for the outputs may have the advantage of a warmer file cache.
+///==========================================================================
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "TFile.h"
+#include "TChain.h"
+#include "TBranch.h"
+#include "TObjArray.h"
+#include "TStopwatch.h"
+#include "Compression.h"
+#include "RVersion.h"
+
+// dk2nu headers
+#include "tree/dk2nu.h"
+#include "tree/dkmeta.h"
+#include "tree/AncChains.h"
+
+#include "flux/common_flux.C"   // AddFluxInputs, splitNumbers
+
+namespace {
+
+  void usage(const char* prog)
+  {
+    std::cerr << "usage: " << prog << " [-o outfile] [-e entries/file]"
+              << " [-C algo:level] [-c algo:level] [-b hotkB,coldkB]"
+              << " [-F cluster] [-S split] [-f pdg,...] [-a 0|1] [-J job]"
+              << " [-T nread] [-t tree] [-m metatree]"
+              << " input.root|@filelist ..." << std::endl;
+  }
+
+  /// "zlib:5" -> ROOT compression settings; -1 if not understood
+  int compressionSettings(const std::string& spec)
+  {
+    size_t colon = spec.find(':');
+    std::string algo  = spec.substr(0,colon);
+    int         level = ( colon == std::string::npos ) ? 5
+                        : std::atoi(spec.c_str()+colon+1);
+    if ( level < 0 || level > 9 ) return -1;
+    if ( algo == "zlib" ) return ROOT::CompressionSettings(ROOT::kZLIB,level);
+    if ( algo == "lzma" ) return ROOT::CompressionSettings(ROOT::kLZMA,level);
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,8,0)
+    if ( algo == "lz4"  ) return ROOT::CompressionSettings(ROOT::kLZ4,level);
+#endif
+    return -1;
+  }
+
+  /// the branches read with GDk2NuFlux's "decay" read profile
+  bool isHotBranch(const std::string& name)
+  {
+    return ( name == "dk2nu"    || name == "job"      || name == "potnum"  ||
+             name == "flagbits" || name == "ancestor" ||
+             name == "ancestor.startt" || name.compare(0,5,"decay") == 0 ||
+             name == "ancchain" || name == "ancleaf"  || name == "anclen" );
+  }
+
+  class BranchSettings
+  {
+  public:
+    int hotzip, coldzip;     ///< compression settings
+    int hotbasket, coldbasket;  ///< basket sizes (bytes)
+  };
+
+  void applyBranchSettings(TObjArray* branches, const BranchSettings& s)
+  {
+    for (int i = 0; i <= branches->GetLast(); ++i) {
+      TBranch* branch = (TBranch*)branches->At(i);
+      bool hot = isHotBranch(branch->GetName());
+      branch->SetCompressionSettings(hot ? s.hotzip : s.coldzip);
+      branch->SetBasketSize(hot ? s.hotbasket : s.coldbasket);
+      applyBranchSettings(branch->GetListOfBranches(),s);
+    }
+  }
+
+  std::string outputName(const std::string& pattern, int ifile, bool split)
+  {
+    if ( ! split ) return pattern;
+    char buff[4096];
+    if ( pattern.find("%d") != std::string::npos ) {
+      snprintf(buff,sizeof(buff),pattern.c_str(),ifile);
+      return buff;
+    }
+    snprintf(buff,sizeof(buff),"_%03d",ifile);
+    size_t dot = pattern.rfind(".root");
+    if ( dot == std::string::npos ) return pattern + buff;
+    return pattern.substr(0,dot) + buff + pattern.substr(dot);
+  }
+
+  /// compare the configuration of a dkmeta entry to the first one's
+  bool sameConfig(const bsim::DkMeta& a, const bsim::DkMeta& b)
+  {
+    if ( a.beamsim  != b.beamsim  || a.physics  != b.physics  ||
+         a.physcuts != b.physcuts || a.tgtcfg   != b.tgtcfg   ||
+         a.horncfg  != b.horncfg  || a.dkvolcfg != b.dkvolcfg ||
+         a.location.size() != b.location.size() ) return false;
+    for (size_t i = 0; i < a.location.size(); ++i) {
+      if ( a.location[i].x != b.location[i].x ||
+           a.location[i].y != b.location[i].y ||
+           a.location[i].z != b.location[i].z ) return false;
+    }
+    return true;
+  }
+
+  //__________________________________________________________________________
+  void reportThroughput(const std::string& what,
+                        const std::vector<std::string>& files,
+                        const std::string& treename, Long64_t nmax)
+  {
+    // read the first nmax entries in full, then just the decay branches
+    Long64_t diskbytes = 0;
+    for (size_t i = 0; i < files.size(); ++i) {
+      TFile* f = TFile::Open(files[i].c_str());
+      if ( f ) diskbytes += f->GetSize();
+      delete f;
+    }
+    for (int pass = 0; pass < 2; ++pass) {
+      TChain* chain = new TChain(treename.c_str());
+      for (size_t i = 0; i < files.size(); ++i) chain->Add(files[i].c_str());
+      bsim::Dk2Nu* dk2nu = new bsim::Dk2Nu;
+      chain->SetBranchAddress("dk2nu",&dk2nu);
+      if ( pass == 1 ) {
+        chain->SetBranchStatus("*",0);
+        chain->SetBranchStatus("dk2nu",1);
+        chain->SetBranchStatus("job",1);
+        chain->SetBranchStatus("potnum",1);
+        chain->SetBranchStatus("decay*",1);
+        chain->SetBranchStatus("flagbits",1);
+        chain->SetBranchStatus("ancestor",1);
+        chain->SetBranchStatus("ancestor.startt",1);
+        chain->SetBranchStatus("ancchain",1);
+        chain->SetBranchStatus("ancleaf",1);
+        chain->SetBranchStatus("anclen",1);
+      }
+      TStopwatch timer;
+      timer.Start();
+      Long64_t n = 0, nbytes = 0;
+      for ( ; n < nmax; ++n) {
+        Int_t nb = chain->GetEntry(n);
+        if ( nb <= 0 ) break;
+        nbytes += nb;
+      }
+      timer.Stop();
+      double rtime = timer.RealTime();
+      std::cout << std::setw(7) << what << ( pass ? " decay" : " full " )
+                << ": " << std::setw(9) << n << " entries in "
+                << std::setprecision(3) << std::setw(7) << rtime << " s, ";
+      if ( rtime > 0 )
+        std::cout << std::setprecision(4) << std::setw(9) << n / rtime
+                  << " entries/s, " << std::setw(7) << nbytes / rtime / 1.e6
+                  << " MB/s (uncompressed)";
+      std::cout << std::endl;
+      chain->ResetBranchAddresses();
+      delete dk2nu;
+      delete chain;
+    }
+    std::cout << std::setw(7) << what << " " << files.size() << " file(s), "
+              << std::setprecision(4) << diskbytes / 1.e6 << " MB on disk"
+              << std::endl;
+  }
+
+} // anonymous namespace
+
+int main(int argc, char** argv)
+{
+  std::string ofname    = "dk2nu_repack.root";
+  Long64_t    perfile   = 0;
+  std::string hotspec   = "zlib:1";
+  std::string coldspec  = "lzma:6";
+  std::string basketspec= "256,64";
+  Long64_t    cluster   = 100000;
+  int         split     = 99;
+  std::string flavspec  = "";
+  bool        shareanc  = false;
+  int         newjob    = -1;
+  bool        jobgiven  = false;
+  Long64_t    nreport   = 200000;
+  std::string treename  = "dk2nuTree";
+  std::string metaname  = "dkmetaTree";
+  std::vector<std::string> inputs;
+
+  for (int i = 1; i < argc; ++i ) {
+    if ( argv[i][0] != '-' ) { inputs.push_back(argv[i]); continue; }
+    if ( i+1 >= argc || std::strlen(argv[i]) != 2 ) {
+      usage(argv[0]);
+      return 1;
+    }
+    const char* val = argv[++i];
+    switch ( argv[i-1][1] ) {
+    case 'o': ofname     = val;                    break;
+    case 'e': perfile    = std::atoll(val);        break;
+    case 'C': hotspec    = val;                    break;
+    case 'c': coldspec   = val;                    break;
+    case 'b': basketspec = val;                    break;
+    case 'F': cluster    = std::atoll(val);        break;
+    case 'S': split      = std::atoi(val);         break;
+    case 'f': flavspec   = val;                    break;
+    case 'a': shareanc   = ( std::atoi(val) != 0 ); break;
+    case 'J': newjob     = std::atoi(val); jobgiven = true; break;
+    case 'T': nreport    = std::atoll(val);        break;
+    case 't': treename   = val;                    break;
+    case 'm': metaname   = val;                    break;
+    default:  usage(argv[0]); return 1;
+    }
+  }
+  if ( inputs.empty() ) { usage(argv[0]); return 1; }
+  if ( perfile > 0 && flavspec != "" ) {
+    // each file would hold some flavors only, so no share of the pots
+    // would be right for it on its own
+    std::cerr << "-f and -e can't be used together" << std::endl;
+    return 1;
+  }
+
+  BranchSettings settings;
+  settings.hotzip  = compressionSettings(hotspec);
+  settings.coldzip = compressionSettings(coldspec);
+  std::vector<double> bsizes = splitNumbers(basketspec);
+  if ( settings.hotzip < 0 || settings.coldzip < 0 || bsizes.size() != 2 ||
+       bsizes[0] <= 0 || bsizes[1] <= 0 ) {
+    std::cerr << "bad compression \"" << hotspec << "\" \"" << coldspec
+              << "\" or basket sizes \"" << basketspec << "\"" << std::endl;
+    return 1;
+  }
+  settings.hotbasket  = int(bsizes[0]*1024);
+  settings.coldbasket = int(bsizes[1]*1024);
+
+  // the inputs
+  TChain* dk2nuChain  = new TChain(treename.c_str());
+  TChain* dkmetaChain = new TChain(metaname.c_str());
+  if ( ! AddFluxInputs(inputs,dk2nuChain,dkmetaChain) ) return 1;
+  std::vector<std::string> infiles;
+  TObjArray* elements = dk2nuChain->GetListOfFiles();
+  for (int i = 0; i <= elements->GetLast(); ++i)
+    infiles.push_back(elements->At(i)->GetTitle());
+
+  // merged metadata: the first entry's, with everyone's pots
+  bsim::DkMeta* dkmeta = new bsim::DkMeta;
+  bsim::DkMeta  merged;
+  double        pots  = 0;
+  Long64_t      nmeta = dkmetaChain->GetEntries();
+  dkmetaChain->SetBranchAddress("dkmeta",&dkmeta);
+  for (Long64_t i = 0; i < nmeta; ++i) {
+    dkmetaChain->GetEntry(i);
+    pots += dkmeta->pots;
+    if ( i == 0 ) {
+      merged = *dkmeta;
+    } else if ( ! sameConfig(merged,*dkmeta) ) {
+      std::cerr << "dkmeta entry " << i << " (job " << dkmeta->job
+                << ") has a different configuration than job "
+                << merged.job << "; merging anyway" << std::endl;
+    }
+  }
+  dkmetaChain->ResetBranchAddresses();
+  if ( nmeta == 0 ) {
+    std::cerr << "no " << metaname << " entries" << std::endl;
+    return 1;
+  }
+  if ( ! jobgiven ) newjob = merged.job;
+
+  const Long64_t nentries = dk2nuChain->GetEntries();
+  std::cout << "dk2nu_repack: " << infiles.size() << " input files, "
+            << nentries << " entries, " << nmeta << " dkmeta entries, "
+            << pots << " pots" << std::endl;
+  if ( nreport > 0 ) reportThroughput("input",infiles,treename,nreport);
+
+  bsim::Dk2Nu* dk2nu = new bsim::Dk2Nu;
+  dk2nuChain->SetBranchAddress("dk2nu",&dk2nu);
+
+  // the order entries go out in: a group (flavor) at a time, each group
+  // in input order, so each is a sequential pass over the input
+  std::vector<int> flavors;
+  std::vector<double> fv = splitNumbers(flavspec);
+  for (size_t i = 0; i < fv.size(); ++i) flavors.push_back(int(fv[i]));
+  const int ngroups = flavors.size() + 1;
+  if ( ngroups > 255 ) { std::cerr << "too many flavors" << std::endl; return 1; }
+  std::vector<unsigned char> group;
+  if ( ngroups > 1 ) group.resize(nentries,flavors.size());
+
+  // and the potnum shift of each input job: the largest potnums of the
+  // jobs that come before it in the input
+  std::map<int,Int_t> potshift;
+  {
+    std::vector<int>    jobs;     // in the order first seen
+    std::map<int,Int_t> maxpot;
+    dk2nuChain->SetBranchStatus("*",0);
+    dk2nuChain->SetBranchStatus("dk2nu",1);
+    dk2nuChain->SetBranchStatus("job",1);
+    dk2nuChain->SetBranchStatus("potnum",1);
+    if ( ngroups > 1 ) dk2nuChain->SetBranchStatus("decay*",1);
+    for (Long64_t j = 0; j < nentries; ++j) {
+      dk2nuChain->GetEntry(j);
+      std::map<int,Int_t>::iterator m = maxpot.find(dk2nu->job);
+      if ( m == maxpot.end() ) {
+        jobs.push_back(dk2nu->job);
+        maxpot[dk2nu->job] = dk2nu->potnum;
+      } else if ( dk2nu->potnum > m->second ) {
+        m->second = dk2nu->potnum;
+      }
+      for (size_t k = 0; k < flavors.size(); ++k)
+        if ( dk2nu->decay.ntype == flavors[k] ) { group[j] = k; break; }
+    }
+    dk2nuChain->SetBranchStatus("*",1);
+    Int_t shift = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+      potshift[jobs[i]] = shift;
+      shift += maxpot[jobs[i]];
+    }
+  }
+
+  // inputs in the shared ancestor layout are read back in full
+  TChain*               ancChain  = 0;
+  bsim::AncChainReader* ancReader = 0;
+
+  const bool splitout = ( perfile > 0 && perfile < nentries );
+  std::vector<std::string> outfiles;
+  TFile*                ofile     = 0;
+  TTree*                otree     = 0;
+  TTree*                ometa     = 0;
+  TTree*                oanc      = 0;
+  bsim::AncChainWriter* ancWriter = 0;
+  bsim::DkMeta*         ometaobj  = new bsim::DkMeta;
+  Long64_t              nfile     = 0;   // entries in the current output
+  int                   filejob   = newjob;  // and its job number
+  Long64_t              nwritten  = 0;
+
+  TStopwatch timer;
+  timer.Start();
+  for (int igroup = 0; igroup < ngroups; ++igroup) {
+    for (Long64_t j = 0; j < nentries; ++j) {
+      if ( ngroups > 1 && group[j] != igroup ) continue;
+      if ( dk2nuChain->GetEntry(j) <= 0 ) {
+        std::cerr << "failed to read entry " << j << std::endl;
+        return 1;
+      }
+      if ( dk2nu->ancchain >= 0 && dk2nu->ancestor.empty() ) {
+        if ( ! ancReader ) {
+          ancChain = new TChain("dkancTree");
+          for (size_t i = 0; i < infiles.size(); ++i)
+            ancChain->Add(infiles[i].c_str());
+          ancReader = new bsim::AncChainReader(ancChain);
+        }
+        if ( ! ancReader->Restore(*dk2nu,dk2nuChain->GetTreeNumber()) ) {
+          std::cerr << "no ancestor chain for entry " << j << std::endl;
+          return 1;
+        }
+      }
+      dk2nu->ancchain = -1;
+      dk2nu->ancleaf  = -1;
+      dk2nu->anclen   = 0;
+
+      if ( ! ofile ) {
+        std::string name = outputName(ofname,outfiles.size(),splitout);
+        filejob = newjob + outfiles.size();
+        ofile = new TFile(name.c_str(),"RECREATE");
+        if ( ofile->IsZombie() ) {
+          std::cerr << "can't write " << name << std::endl;
+          return 1;
+        }
+        ofile->SetCompressionSettings(settings.coldzip);
+        otree = new TTree(treename.c_str(),"neutrino ntuple");
+        otree->Branch("dk2nu","bsim::Dk2Nu",&dk2nu,settings.hotbasket,split);
+        otree->SetAutoFlush(cluster);
+        applyBranchSettings(otree->GetListOfBranches(),settings);
+        ometa = new TTree(metaname.c_str(),"neutrino ntuple metadata");
+        ometa->Branch("dkmeta","bsim::DkMeta",&ometaobj,32000,1);
+        if ( shareanc ) {
+          oanc = new TTree("dkancTree","neutrino ntuple ancestor chains");
+          oanc->SetAutoFlush(cluster);
+          ancWriter = new bsim::AncChainWriter(oanc);
+          applyBranchSettings(oanc->GetListOfBranches(),settings);
+        }
+        outfiles.push_back(name);
+        nfile = 0;
+      }
+
+      dk2nu->potnum += potshift[dk2nu->job];
+      dk2nu->job     = filejob;
+
+      if ( ancWriter ) ancWriter->Fill(otree,*dk2nu);
+      else             otree->Fill();
+      ++nfile;
+      ++nwritten;
+      // ROOT resizes the baskets at the first flush; put ours back
+      if ( nfile == cluster ) applyBranchSettings(otree->GetListOfBranches(),settings);
+
+      if ( nwritten == nentries || ( splitout && nfile == perfile ) ) {
+        *ometaobj      = merged;
+        ometaobj->job  = filejob;
+        ometaobj->pots = pots * double(nfile) / double(nentries);
+        ometa->Fill();
+        if ( ancWriter ) ancWriter->Flush();
+        ofile->Write();
+        std::cout << "wrote " << nfile << " entries, " << ometaobj->pots
+                  << " pots, job " << filejob << " to " << outfiles.back()
+                  << std::endl;
+        ofile->Close();
+        delete ancWriter;
+        delete ofile;   // and the trees in it
+        ancWriter = 0;
+        ofile = 0;
+        otree = ometa = oanc = 0;
+      }
+    }
+  }
+  timer.Stop();
+  std::cout << "dk2nu_repack: " << nwritten << " entries in "
+            << std::setprecision(3) << timer.RealTime() << " s" << std::endl;
+
+  if ( nreport > 0 && ! outfiles.empty() )
+    reportThroughput("output",outfiles,treename,nreport);
+
+  dk2nuChain->ResetBranchAddresses();
+  delete ancReader;
+  delete ancChain;
+  delete dk2nu;
+  delete dkmeta;
+  delete ometaobj;
+  delete dk2nuChain;
+  delete dkmetaChain;
+  return 0;
+}
@@ -0,0 +1,257 @@
+/**
+ * \class AncChains
+ * \file  AncChains.cc
+ *
+ * \brief Ancestor chains shared by the neutrinos of one proton, and the
+ *        writer and reader for the dk2nu layout that uses them.
+ *
+ */
+
+#include "AncChains.h"
+#include "dflt.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+#include "TTree.h"
+#include "TChain.h"
+#include "TChainElement.h"
+#include "TFile.h"
+#include "TDirectory.h"
+
+namespace {
+  bool sameAncestor(const bsim::Ancestor& a, const bsim::Ancestor& b)
+  {
+    return ( a.pdg     == b.pdg     && a.nucleus == b.nucleus &&
+             a.startx  == b.startx  && a.starty  == b.starty  &&
+             a.startz  == b.startz  && a.startt  == b.startt  &&
+             a.startpx == b.startpx && a.startpy == b.startpy &&
+             a.startpz == b.startpz &&
+             a.stoppx  == b.stoppx  && a.stoppy  == b.stoppy  &&
+             a.stoppz  == b.stoppz  &&
+             a.polx    == b.polx    && a.poly    == b.poly    &&
+             a.polz    == b.polz    &&
+             a.pprodpx == b.pprodpx && a.pprodpy == b.pprodpy &&
+             a.pprodpz == b.pprodpz &&
+             a.proc    == b.proc    && a.ivol    == b.ivol    &&
+             a.imat    == b.imat );
+  }
+}
+
+//-----------------------------------------------------------------------------
+ClassImp(bsim::AncChains)
+bsim::AncChains::AncChains() { clear(); }
+bsim::AncChains::~AncChains() { ; }
+void bsim::AncChains::clear(const std::string &)
+{
+  job    = bsim::kDfltInt;
+  potnum = 0;
+  node.clear();      /// clear the vector
+  parent.clear();    /// clear the vector
+  firsts.clear();
+  children.clear();
+}
+std::string bsim::AncChains::AsString(const std::string& /* opt */) const
+{
+  std::ostringstream s;
+  s << "bsim::AncChains: job " << job << " pot# " << potnum
+    << ", " << node.size() << " ancestors";
+  for ( size_t i = 0; i < node.size(); ++i ) {
+    s << "\n[" << std::setw(3) << i << "<-" << std::setw(3) << parent[i]
+      << "] " << node[i];
+  }
+  return s.str();
+}
+
+void bsim::AncChains::IndexChildren()
+{
+  // for nodes that didn't come through Add() (read from a file, say)
+  firsts.clear();
+  children.assign(node.size(),std::vector<Int_t>());
+  for ( size_t j = 0; j < node.size(); ++j ) {
+    if ( parent[j] < 0 ) firsts.push_back(j);
+    else                 children[parent[j]].push_back(j);
+  }
+}
+
+Int_t bsim::AncChains::Add(const std::vector<bsim::Ancestor>& chain)
+{
+  if ( children.size() != node.size() ) IndexChildren();
+
+  // follow the chain down the nodes already there for as long as it
+  // matches one; the rest of it is new
+  Int_t cur = -1;
+  size_t i = 0;
+  for ( ; i < chain.size(); ++i ) {
+    const std::vector<Int_t>& kids = ( cur < 0 ) ? firsts : children[cur];
+    Int_t next = -1;
+    for ( size_t k = 0; k < kids.size(); ++k ) {
+      if ( sameAncestor(node[kids[k]],chain[i]) ) {
+        next = kids[k];
+        break;
+      }
+    }
+    if ( next < 0 ) break;
+    cur = next;
+  }
+  for ( ; i < chain.size(); ++i ) {
+    Int_t inew = node.size();
+    node.push_back(chain[i]);
+    parent.push_back(cur);
+    if ( cur < 0 ) firsts.push_back(inew);
+    else           children[cur].push_back(inew);
+    children.push_back(std::vector<Int_t>());
+    cur = inew;
+  }
+  return cur;
+}
+
+bool bsim::AncChains::Chain(Int_t leaf, Int_t len,
+                            std::vector<bsim::Ancestor>& chain) const
+{
+  chain.resize(len > 0 ? len : 0);
+  Int_t cur = leaf;
+  for ( Int_t i = len-1; i >= 0; --i ) {
+    if ( cur < 0 || cur >= (Int_t)node.size() ) {
+      chain.clear();
+      return false;
+    }
+    chain[i] = node[cur];
+    cur = parent[cur];
+  }
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const bsim::AncChains& ancchains)
+{
+  os << ancchains.AsString();
+  return os;
+}
+
+//-----------------------------------------------------------------------------
+bsim::AncChainWriter::AncChainWriter(TTree* dkancTree)
+  : fTree(dkancTree), fChains(new bsim::AncChains)
+{
+  fTree->Branch("dkanc","bsim::AncChains",&fChains,32000,1);
+}
+
+bsim::AncChainWriter::~AncChainWriter()
+{
+  delete fChains;
+}
+
+Int_t bsim::AncChainWriter::Fill(TTree* dk2nuTree, bsim::Dk2Nu& dk2nu)
+{
+  if ( dk2nu.ancestor.empty() ) return dk2nuTree->Fill();
+
+  // parents' chains can only be shared within a proton
+  if ( dk2nu.job != fChains->job || dk2nu.potnum != fChains->potnum )
+    Flush();
+  fChains->job    = dk2nu.job;
+  fChains->potnum = dk2nu.potnum;
+
+  Int_t leaf = fChains->Add(dk2nu.ancestor);
+
+  std::vector<bsim::Ancestor> keep;
+  keep.swap(dk2nu.ancestor);
+  dk2nu.ancchain = fTree->GetEntries();
+  dk2nu.ancleaf  = leaf;
+  dk2nu.anclen   = keep.size();
+
+  Int_t nbytes = dk2nuTree->Fill();
+
+  keep.swap(dk2nu.ancestor);
+  dk2nu.ancchain = -1;
+  dk2nu.ancleaf  = -1;
+  dk2nu.anclen   = 0;
+  return nbytes;
+}
+
+void bsim::AncChainWriter::Flush()
+{
+  if ( fChains->node.empty() ) return;
+  fTree->Fill();
+  fChains->clear();
+}
+
+//-----------------------------------------------------------------------------
+bsim::AncChainReader::AncChainReader(TTree* dkancTree)
+  : fTree(dkancTree), fChains(new bsim::AncChains),
+    fFile(0), fFileTree(0), fTreeNumber(-1), fEntry(-1)
+{
+  // a chain's files are read through trees of their own (OpenTree), so
+  // that none is opened before it is needed
+  if ( ! dynamic_cast<TChain*>(fTree) )
+    fTree->SetBranchAddress("dkanc",&fChains);
+}
+
+bsim::AncChainReader::~AncChainReader()
+{
+  if ( ! fFile ) fTree->ResetBranchAddresses();
+  delete fFile;
+  delete fChains;
+}
+
+bool bsim::AncChainReader::OpenTree(int itree)
+{
+  // a chain's entry offsets are only known for files it has been
+  // through, so read the itree-th file's dkancTree itself; ancchain is
+  // the entry within it
+  delete fFile;
+  fFile       = 0;
+  fFileTree   = 0;
+  fTreeNumber = -1;
+  fEntry      = -1;
+
+  TChain* chain = dynamic_cast<TChain*>(fTree);
+  TChainElement* elem = (TChainElement*)chain->GetListOfFiles()->At(itree);
+  if ( ! elem ) return false;
+  {
+    TDirectory::TContext keepdir(0);
+    fFile = TFile::Open(elem->GetTitle(),"READ");
+  }
+  if ( fFile ) fFile->GetObject(elem->GetName(),fFileTree);
+  if ( ! fFileTree ) {
+    std::cerr << "bsim::AncChainReader no " << elem->GetName()
+              << " in " << elem->GetTitle() << std::endl;
+    delete fFile;
+    fFile = 0;
+    return false;
+  }
+  fFileTree->SetBranchAddress("dkanc",&fChains);
+  fTreeNumber = itree;
+  return true;
+}
+
+bool bsim::AncChainReader::Restore(bsim::Dk2Nu& dk2nu, int itree)
+{
+  if ( dk2nu.ancchain < 0 || ! dk2nu.ancestor.empty() ) return true;
+
+  Long64_t ientry = dk2nu.ancchain;
+  TTree*   tree   = fTree;
+  TChain*  chain  = dynamic_cast<TChain*>(fTree);
+  if ( chain ) {
+    if ( itree < 0 || itree >= chain->GetNtrees() ) return false;
+    if ( itree != fTreeNumber && ! OpenTree(itree) ) return false;
+    tree = fFileTree;
+  }
+  if ( ientry != fEntry ) {
+    fEntry = -1;
+    if ( tree->GetEntry(ientry) <= 0 ) {
+      std::cerr << "bsim::AncChainReader no dkanc entry " << ientry
+                << " for job " << dk2nu.job << " pot# " << dk2nu.potnum
+                << std::endl;
+      return false;
+    }
+    fEntry = ientry;
+  }
+  if ( fChains->job != dk2nu.job || fChains->potnum != dk2nu.potnum ) {
+    std::cerr << "bsim::AncChainReader dkanc entry " << ientry
+              << " is job " << fChains->job << " pot# " << fChains->potnum
+              << ", not job " << dk2nu.job << " pot# " << dk2nu.potnum
+              << std::endl;
+    return false;
+  }
+  return fChains->Chain(dk2nu.ancleaf,dk2nu.anclen,dk2nu.ancestor);
+}
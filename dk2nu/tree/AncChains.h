@@ -0,0 +1,143 @@
+///----------------------------------------------------------------------------
+/**
+ * \class bsim::AncChains
+ * \file  AncChains.h
+ *
+ * \brief Ancestor chains shared by the neutrinos of one proton, for an
+ *        optional dk2nu file layout in which each chain is written once.
+ *
+ *        Neutrinos from the same proton (potnum) have ancestor chains
+ *        that share a prefix, from the proton down to where their
+ *        cascades part.  In the shared layout the chains of a proton are
+ *        kept as a tree of unique ancestors (each with the index of its
+ *        parent) in one entry of a side tree, "dkancTree" (branch
+ *        "dkanc"), and each dk2nu entry has an empty ancestor vector and
+ *        refers to its chain by (ancchain, ancleaf, anclen).
+ *
+ *        Writing:  bsim::AncChainWriter in place of dk2nuTree->Fill()
+ *        Reading:  bsim::AncChainReader::Restore() after GetEntry();
+ *                  it does nothing for entries with their own ancestors
+ *
+ */
+///----------------------------------------------------------------------------
+
+#ifndef BSIM_ANCCHAINS_H
+#define BSIM_ANCCHAINS_H
+
+#include "TROOT.h"
+#include "TObject.h"
+
+#include <vector>
+#include <string>
+
+#include "dk2nu.h"
+
+class TTree;
+class TFile;
+
+namespace bsim {
+
+  ///---------------------------------------------------------------------------
+  /**
+   *============================================================================
+   *  One proton's ancestors: nodes along with the index of their parent
+   *  (-1 for the first of a chain); a chain is found by walking from its
+   *  last node back through the parents
+   */
+  class AncChains
+  {
+  public:
+    Int_t    job;                          ///< identifying job #
+    Int_t    potnum;                       ///< proton # processed by simulation
+    std::vector<bsim::Ancestor> node;      ///< unique ancestors
+    std::vector<Int_t>          parent;    ///< index of each node's parent
+
+  public:
+    AncChains();
+    virtual     ~AncChains();
+    void        clear(const std::string &opt = "");    ///< reset everything
+    std::string AsString(const std::string& opt = "") const;
+
+    /// add a chain, sharing what it can with those already added;
+    /// returns the index of its last node (-1 for an empty chain)
+    Int_t       Add(const std::vector<bsim::Ancestor>& chain);
+    /// the len ancestors ending at node leaf; false if they aren't there
+    bool        Chain(Int_t leaf, Int_t len,
+                      std::vector<bsim::Ancestor>& chain) const;
+
+  private:
+    void        IndexChildren();
+
+    std::vector<Int_t>                firsts;    //! nodes with no parent
+    std::vector< std::vector<Int_t> > children;  //! each node's children
+
+    ClassDef(bsim::AncChains,1)
+  };  // end-of-class bsim::AncChains
+
+  ///---------------------------------------------------------------------------
+  /**
+   *============================================================================
+   *  Fills dk2nu entries with their ancestor chains moved to a dkancTree
+   *  (booked alongside the dk2nuTree in the same file).  Entries of the
+   *  same proton should be filled one after another; a new proton (or
+   *  job) writes out the chains of the previous one.
+   */
+  class AncChainWriter
+  {
+  public:
+    /// adds the "dkanc" branch to dkancTree
+    AncChainWriter(TTree* dkancTree);
+    ~AncChainWriter();
+
+    /// dk2nuTree->Fill() for dk2nu in the shared layout;
+    /// dk2nu itself is left as it was
+    Int_t  Fill(TTree* dk2nuTree, bsim::Dk2Nu& dk2nu);
+    /// write out the chains of the last proton (before writing the trees)
+    void   Flush();
+
+  private:
+    TTree*           fTree;
+    bsim::AncChains* fChains;
+    AncChainWriter(const AncChainWriter&);
+    AncChainWriter& operator=(const AncChainWriter&);
+  };
+
+  ///---------------------------------------------------------------------------
+  /**
+   *============================================================================
+   *  Puts ancestor chains back into dk2nu entries read from files with
+   *  the shared layout.  dkancTree may be a TChain over the same files,
+   *  in the same order, as the chain the entries come from; each file's
+   *  dkancTree is then opened on its own when first needed.
+   */
+  class AncChainReader
+  {
+  public:
+    /// sets the "dkanc" branch address of dkancTree
+    AncChainReader(TTree* dkancTree);
+    ~AncChainReader();
+
+    /// fill dk2nu.ancestor if it refers to a shared chain; itree is the
+    /// file (TChain tree number) the entry came from.  Entries in order
+    /// read each dkancTree entry once.  False if the chain can't be had.
+    bool   Restore(bsim::Dk2Nu& dk2nu, int itree = 0);
+
+  private:
+    bool   OpenTree(int itree);
+
+    TTree*           fTree;
+    bsim::AncChains* fChains;
+    TFile*           fFile;      ///< file of the chain now read from
+    TTree*           fFileTree;  ///< its dkancTree
+    int              fTreeNumber;///< its number in the chain (-1 = none)
+    Long64_t         fEntry;     ///< dkancTree entry now in fChains
+    AncChainReader(const AncChainReader&);
+    AncChainReader& operator=(const AncChainReader&);
+  };
+
+} // end-of-namespace "bsim"
+
+// not part of namespace bsim
+std::ostream& operator<<(std::ostream& os, const bsim::AncChains& ancchains);
+
+#endif
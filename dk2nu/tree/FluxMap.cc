@@ -0,0 +1,182 @@
+/**
+ * \class FluxMap
+ * \file  FluxMap.cc
+ *
+ * \brief Energy spectra of the flux on a regular 3-d grid of points
+ *        (beam coordinates, cm) for a set of neutrino flavors.
+ *
+ */
+
+#include "FluxMap.h"
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+ClassImp(bsim::FluxMap)
+bsim::FluxMap::FluxMap() { clear(); }
+bsim::FluxMap::~FluxMap() { ; }
+void bsim::FluxMap::clear(const std::string &)
+{
+  nx   = 0;
+  ny   = 0;
+  nz   = 0;
+  xlo  = 0;
+  xhi  = 0;
+  ylo  = 0;
+  yhi  = 0;
+  zlo  = 0;
+  zhi  = 0;
+  ebins.clear();
+  pdgs.clear();
+  pots = 0;
+  flux.clear();
+}
+std::string bsim::FluxMap::AsString(const std::string& /* opt */) const
+{
+  std::ostringstream s;
+  s << "FluxMap: " << nx << "x" << ny << "x" << nz << " points"
+    << " x=[" << xlo << "," << xhi << "]"
+    << " y=[" << ylo << "," << yhi << "]"
+    << " z=[" << zlo << "," << zhi << "] cm\n";
+  s << "         " << NEnergyBins() << " energy bins";
+  if ( ! ebins.empty() )
+    s << " [" << ebins.front() << "," << ebins.back() << "] GeV";
+  s << ", pdgs {";
+  for (size_t i = 0; i < pdgs.size(); ++i) s << ( i ? "," : "" ) << pdgs[i];
+  s << "}, " << pots << " pots";  // no \n on last line
+
+  return s.str();
+}
+
+void bsim::FluxMap::SetGrid(int nxp, double xlop, double xhip,
+                            int nyp, double ylop, double yhip,
+                            int nzp, double zlop, double zhip,
+                            const std::vector<double>& ebinsp,
+                            const std::vector<int>& pdgsp)
+{
+  nx = nxp; xlo = xlop; xhi = xhip;
+  ny = nyp; ylo = ylop; yhi = yhip;
+  nz = nzp; zlo = zlop; zhi = zhip;
+  ebins.assign(ebinsp.begin(),ebinsp.end());
+  pdgs.assign(pdgsp.begin(),pdgsp.end());
+  size_t ne = ( ebins.size() > 1 ) ? ebins.size()-1 : 0;
+  flux.assign(pdgs.size()*NPoints()*ne,0);
+}
+
+void bsim::FluxMap::Point(size_t ipt, double& x, double& y, double& z) const
+{
+  int iz = ipt % nz;  ipt /= nz;
+  int iy = ipt % ny;  ipt /= ny;
+  int ix = ipt;
+  x = ( nx > 1 ) ? xlo + ix*(xhi-xlo)/(nx-1) : xlo;
+  y = ( ny > 1 ) ? ylo + iy*(yhi-ylo)/(ny-1) : ylo;
+  z = ( nz > 1 ) ? zlo + iz*(zhi-zlo)/(nz-1) : zlo;
+}
+
+int bsim::FluxMap::FlavorIndex(int pdg) const
+{
+  for (size_t i = 0; i < pdgs.size(); ++i) if ( pdgs[i] == pdg ) return i;
+  return -1;
+}
+
+namespace {
+  // lower grid index and fraction along one axis; false if outside
+  bool axisCell(double v, int n, double lo, double hi, int& i, double& f)
+  {
+    i = 0;
+    f = 0;
+    if ( n <= 1 ) return true;
+    double t = ( v - lo ) / ( hi - lo ) * ( n - 1 );
+    if ( ! ( t >= 0 && t <= n-1 ) ) return false;
+    i = std::min(int(t),n-2);
+    f = t - i;
+    return true;
+  }
+}
+
+bool bsim::FluxMap::Corners(double x, double y, double z,
+                            size_t ipt[8], double w[8]) const
+{
+  int    ix, iy, iz;
+  double fx, fy, fz;
+  if ( ! axisCell(x,nx,xlo,xhi,ix,fx) ||
+       ! axisCell(y,ny,ylo,yhi,iy,fy) ||
+       ! axisCell(z,nz,zlo,zhi,iz,fz)    ) return false;
+  // a one point axis has no upper neighbor; its weight is always 0
+  int dx = ( nx > 1 ), dy = ( ny > 1 ), dz = ( nz > 1 );
+  for (int k = 0; k < 8; ++k) {
+    int jx = ( k & 4 ) ? 1 : 0;
+    int jy = ( k & 2 ) ? 1 : 0;
+    int jz = ( k & 1 ) ? 1 : 0;
+    ipt[k] = ( size_t( ix + jx*dx )*ny + ( iy + jy*dy ) )*nz + ( iz + jz*dz );
+    w[k]   = ( jx ? fx : 1-fx ) * ( jy ? fy : 1-fy ) * ( jz ? fz : 1-fz );
+  }
+  return true;
+}
+
+double bsim::FluxMap::Flux(int pdg, double x, double y, double z,
+                           double enu) const
+{
+  int iflav = FlavorIndex(pdg);
+  int ne    = NEnergyBins();
+  if ( iflav < 0 || ne < 1 ) return 0;
+  if ( ! ( enu >= ebins[0] && enu < ebins[ne] ) ) return 0;
+
+  size_t ipt[8];
+  double w[8];
+  if ( ! Corners(x,y,z,ipt,w) ) return 0;
+
+  // the two bins whose centers bracket enu
+  int ie = int( std::upper_bound(ebins.begin(),ebins.end(),enu)
+                - ebins.begin() ) - 1;
+  double c  = 0.5 * ( ebins[ie] + ebins[ie+1] );
+  int    ie0 = ie, ie1 = ie;
+  double f  = 0;
+  if ( enu < c && ie > 0 ) {
+    double c0 = 0.5 * ( ebins[ie-1] + ebins[ie] );
+    ie0 = ie-1;
+    f   = ( enu - c0 ) / ( c - c0 );
+  } else if ( enu > c && ie < ne-1 ) {
+    double c1 = 0.5 * ( ebins[ie+1] + ebins[ie+2] );
+    ie1 = ie+1;
+    f   = ( enu - c ) / ( c1 - c );
+  }
+
+  double sum = 0;
+  for (int k = 0; k < 8; ++k) {
+    if ( w[k] == 0 ) continue;
+    size_t i0 = Index(iflav,ipt[k],ie0);
+    size_t i1 = Index(iflav,ipt[k],ie1);
+    sum += w[k] * ( ( 1 - f ) * flux[i0] + f * flux[i1] );
+  }
+  return sum;
+}
+
+bool bsim::FluxMap::Spectrum(int pdg, double x, double y, double z,
+                             std::vector<double>& spec) const
+{
+  int ne = NEnergyBins();
+  spec.assign(ne > 0 ? ne : 0,0.);
+  int iflav = FlavorIndex(pdg);
+  if ( iflav < 0 || ne < 1 ) return false;
+
+  size_t ipt[8];
+  double w[8];
+  if ( ! Corners(x,y,z,ipt,w) ) return false;
+
+  for (int k = 0; k < 8; ++k) {
+    if ( w[k] == 0 ) continue;
+    const Float_t* f = &flux[Index(iflav,ipt[k],0)];
+    for (int ie = 0; ie < ne; ++ie) spec[ie] += w[k] * f[ie];
+  }
+  return true;
+}
+
+std::ostream& operator<<(std::ostream& os, const bsim::FluxMap& fluxmap)
+{
+  os << fluxmap.AsString();
+  return os;
+}
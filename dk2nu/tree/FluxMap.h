@@ -0,0 +1,99 @@
+///----------------------------------------------------------------------------
+/**
+ * \class bsim::FluxMap
+ * \file  FluxMap.h
+ *
+ * \brief Energy spectra of the flux on a regular 3-d grid of points
+ *        (beam coordinates, cm) for a set of neutrino flavors, so that
+ *        the flux at any point within the grid can be had by
+ *        interpolation rather than by going back to the decays.
+ *        Filled by the dk2nu_fluxmap tool (scripts/flux) and written
+ *        to its output file as "fluxmap"; read back with
+ *           bsim::FluxMap* fmap = 0;
+ *           file->GetObject("fluxmap",fmap);
+ *
+ *        Values are nu / m^2 / GeV / POT, i.e. a density in energy,
+ *        averaged over each energy bin.
+ *
+ */
+///----------------------------------------------------------------------------
+
+#ifndef BSIM_FLUXMAP_H
+#define BSIM_FLUXMAP_H
+
+#include "TROOT.h"
+#include "TObject.h"
+
+#include <vector>
+#include <string>
+
+namespace bsim {
+  /**
+   *  Data members are public, as for the other dk2nu classes; the
+   *  methods are there to index and interpolate them.
+   */
+
+  ///---------------------------------------------------------------------------
+  /**
+   *============================================================================
+   *  grid points are lo + i*(hi-lo)/(n-1), i = 0 ... n-1, on each axis;
+   *  an axis with a single point is taken as constant along it
+   */
+  class FluxMap
+  {
+  public:
+    Int_t    nx, ny, nz;          ///< number of grid points along x, y, z
+    Double_t xlo, xhi;            ///< first and last x grid point (cm)
+    Double_t ylo, yhi;            ///< first and last y grid point (cm)
+    Double_t zlo, zhi;            ///< first and last z grid point (cm)
+    std::vector<Double_t> ebins;  ///< energy bin edges (GeV)
+    std::vector<Int_t>    pdgs;   ///< neutrino flavors mapped
+    Double_t pots;                ///< protons-on-target of the input
+    std::vector<Float_t>  flux;   ///< [flavor][ix][iy][iz][ienergy]
+
+  public:
+    FluxMap();
+    virtual     ~FluxMap();
+    void        clear(const std::string &opt = "");    ///< reset everything
+    std::string AsString(const std::string& opt = "") const;
+
+    /// set the grid, binning and flavors; the flux is zeroed
+    void   SetGrid(int nx, double xlo, double xhi,
+                   int ny, double ylo, double yhi,
+                   int nz, double zlo, double zhi,
+                   const std::vector<double>& ebins,
+                   const std::vector<int>& pdgs);
+
+    size_t NPoints() const { return size_t(nx)*ny*nz; }
+    int    NEnergyBins() const { return int(ebins.size()) - 1; }
+    /// position of grid point ipt = (ix*ny + iy)*nz + iz
+    void   Point(size_t ipt, double& x, double& y, double& z) const;
+    /// index into flux; -1 for a flavor that isn't mapped
+    int    FlavorIndex(int pdg) const;
+    size_t Index(int iflav, size_t ipt, int ie) const
+      { return ( size_t(iflav)*NPoints() + ipt )*NEnergyBins() + ie; }
+
+    /// flux density at (x,y,z) for energy enu: trilinear in position,
+    /// linear in energy between bin centers (flat in the outer halves
+    /// of the first and last bins).  Zero outside the grid or binning.
+    double Flux(int pdg, double x, double y, double z, double enu) const;
+
+    /// the bin-averaged spectrum at (x,y,z), trilinear in position;
+    /// false (and spec zeroed) outside the grid
+    bool   Spectrum(int pdg, double x, double y, double z,
+                    std::vector<double>& spec) const;
+
+  private:
+    /// the corners around (x,y,z) and their weights; false if outside
+    bool   Corners(double x, double y, double z,
+                   size_t ipt[8], double w[8]) const;
+
+    ClassDef(bsim::FluxMap,1)
+  };  // end-of-class bsim::FluxMap
+
+} // end-of-namespace "bsim"
+
+// not part of namespace bsim
+std::ostream& operator<<(std::ostream& os, const bsim::FluxMap& fluxmap);
+
+#endif
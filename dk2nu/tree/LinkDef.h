@@ -24,6 +24,12 @@
 
 #pragma link C++ class bsim::NuChoice+;
 
+#pragma link C++ class bsim::FluxMap+;
+
+#pragma link C++ class bsim::AncChains+;
+#pragma link C++ class bsim::AncChainWriter;
+#pragma link C++ class bsim::AncChainReader;
+
 #pragma link C++ function bsim::readWeightLocations;
 #pragma link C++ function bsim::printWeightLocations;
 #pragma link C++ function bsim::calcLocationWeights;
@@ -42,5 +48,7 @@
 #pragma link C++ function operator<<(std::ostream&, const bsim::DkMeta&);
 
 #pragma link C++ function operator<<(std::ostream&, const bsim::NuChoice&);
+#pragma link C++ function operator<<(std::ostream&, const bsim::FluxMap&);
+#pragma link C++ function operator<<(std::ostream&, const bsim::AncChains&);
 #endif
 
@@ -1,52 +1,179 @@
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 #include "tree/calcLocationWeights.h"
 
 #include "tree/dkmeta.h"
 #include "tree/dk2nu.h"
 
+namespace {
+
+  // for now ... these masses _should_ come from TDatabasePDG 
+  // but use these hard-coded values to "exactly" reproduce old code
+  //
+  const double kPIMASS = 0.13957;
+  const double kKMASS  = 0.49368;
+  const double kK0MASS = 0.49767;
+  const double kMUMASS = 0.105658389;
+  const double kOMEGAMASS = 1.67245;
+
+  const int kpdg_nue       =   12;  // extended Geant 53
+  const int kpdg_nuebar    =  -12;  // extended Geant 52
+  const int kpdg_numu      =   14;  // extended Geant 56
+  const int kpdg_numubar   =  -14;  // extended Geant 55
+
+  const int kpdg_muplus     =   -13;  // Geant  5
+  const int kpdg_muminus    =    13;  // Geant  6
+  const int kpdg_pionplus   =   211;  // Geant  8
+  const int kpdg_pionminus  =  -211;  // Geant  9
+  const int kpdg_k0long     =   130;  // Geant 10  ( K0=311, K0S=310 )
+  const int kpdg_k0short    =   310;  // Geant 16
+  const int kpdg_k0mix      =   311;  
+  const int kpdg_kaonplus   =   321;  // Geant 11
+  const int kpdg_kaonminus  =  -321;  // Geant 12
+  const int kpdg_omegaminus =  3334;  // Geant 24
+  const int kpdg_omegaplus  = -3334;  // Geant 32
+
+  const double kRDET = 100.0;   // set to flux per 100 cm radius
+
+  // in principle we should get these from the particle DB
+  // but for consistency testing use the hardcoded values
+  // (negative for an unknown parent)
+  double parentMass(int ptype)
+  {
+    switch ( ptype ) {
+    case kpdg_pionplus:
+    case kpdg_pionminus:
+      return kPIMASS;
+    case kpdg_kaonplus:
+    case kpdg_kaonminus:
+      return kKMASS;
+    case kpdg_k0long:
+    case kpdg_k0short:
+    case kpdg_k0mix:
+      return kK0MASS;
+    case kpdg_muplus:
+    case kpdg_muminus:
+      return kMUMASS;
+    case kpdg_omegaminus:
+    case kpdg_omegaplus:
+      return kOMEGAMASS;
+    default:
+      return -1.0;
+    }
+  }
+
+  // coordinates (u,v) of the point in the window plane closest to
+  // base + w, for the window spanned by d1 and d2
+  void windowUV(const TVector3& w, const TVector3& d1, const TVector3& d2,
+                double& u, double& v)
+  {
+    double a11 = d1.Dot(d1), a12 = d1.Dot(d2), a22 = d2.Dot(d2);
+    double b1  = w.Dot(d1),  b2  = w.Dot(d2);
+    double det = a11*a22 - a12*a12;
+    if ( det <= 0 ) { u = v = -1; return; }  // degenerate, never "inside"
+    u = ( b1*a22 - b2*a12 ) / det;
+    v = ( b2*a11 - b1*a12 ) / det;
+  }
+
+  // squared distance from the origin to the segment p0 + t*e, 0<=t<=1
+  double segmentDist2(const TVector3& p0, const TVector3& e)
+  {
+    double e2 = e.Mag2();
+    double t  = ( e2 > 0 ) ? -p0.Dot(e)/e2 : 0;
+    if ( t < 0 ) t = 0;
+    if ( t > 1 ) t = 1;
+    return ( p0 + t*e ).Mag2();
+  }
+
+  // largest cosine between unit vector dir and p0 + t*e, 0<=t<=1;
+  // (a+bt)/sqrt(c+dt+et^2) has at most one interior extremum
+  double segmentCosMax(const TVector3& dir, const TVector3& p0,
+                       const TVector3& e)
+  {
+    double a = dir.Dot(p0), b = dir.Dot(e);
+    double c = p0.Mag2(), d = 2.0*p0.Dot(e), ee = e.Mag2();
+    double ts[3] = { 0., 1., -1. };
+    double denom = b*d - 2.0*a*ee;
+    if ( denom != 0 ) ts[2] = ( a*d - 2.0*b*c ) / denom;
+    double cosmax = -1.0;
+    for (int k = 0; k < 3; ++k ) {
+      double t = ts[k];
+      if ( t < 0 || t > 1 ) continue;
+      double q = c + d*t + ee*t*t;
+      if ( q <= 0 ) return 1.0;  // decay point on the window edge
+      double cost = ( a + b*t ) / TMath::Sqrt(q);
+      if ( cost > cosmax ) cosmax = cost;
+    }
+    return cosmax;
+  }
+
+}
+
 /// user interface
 void bsim::calcLocationWeights(const bsim::DkMeta* dkmeta, bsim::Dk2Nu* dk2nu)
 {
+  static const std::string rkey = "random decay";
+
   size_t nloc = dkmeta->location.size();
-  for (size_t iloc = 0; iloc < nloc; ++iloc ) {
+  size_t iloc0 = 0;
+  if ( nloc > 0 && dkmeta->location[0].name == rkey ) {
     // skip calculation for random location ... should already be filled
-    const std::string rkey = "random decay";
-    if ( dkmeta->location[iloc].name == rkey ) {
-      if ( iloc != 0 ) {
+    if ( dk2nu->nuray.size() != 1 ) {
+      std::cerr << "calcLocationWeights \"" << rkey << "\""
+                << " nuenergy[" << 0 << "] not filled" << std::endl;
+      assert(0);
+    }
+    iloc0 = 1;
+  }
+  if ( nloc > iloc0 ) dk2nu->nuray.reserve(dk2nu->nuray.size() + nloc - iloc0);
+
+  // evaluate the locations in blocks, so the positions can be handed
+  // to calcEnuWgt as plain arrays without allocating
+  const size_t kBlock = 16;
+  double x[kBlock], y[kBlock], z[kBlock], enu[kBlock], wgt[kBlock];
+  int    status[kBlock];
+
+  const bsim::Decay& decay = dk2nu->decay;
+  for (size_t ifirst = iloc0; ifirst < nloc; ifirst += kBlock ) {
+    size_t n = std::min(kBlock,nloc-ifirst);
+    for (size_t k = 0; k < n; ++k ) {
+      const bsim::Location& loc = dkmeta->location[ifirst+k];
+      if ( loc.name == rkey ) {
         std::cerr << "calcLocationWeights \"" << rkey << "\""
                   << " isn't the 0-th entry" << std::endl;
         assert(0);
       }
-      if ( dk2nu->nuray.size() != 1 ) {
-        std::cerr << "calcLocationWeights \"" << rkey << "\""
-                  << " nuenergy[" << iloc << "] not filled" << std::endl;
-        assert(0);
-      }
-      continue;
+      x[k] = loc.x;  // position to evaluate
+      y[k] = loc.y;
+      z[k] = loc.z;
     }
-    TVector3 xyzDet(dkmeta->location[iloc].x,
-                    dkmeta->location[iloc].y,
-                    dkmeta->location[iloc].z);  // position to evaluate
-    double enu_xy = 0;  // give a default value
-    double wgt_xy = 0;  // give a default value
-    int status = bsim::calcEnuWgt(dk2nu,xyzDet,enu_xy,wgt_xy);
-    if ( status != 0 ) {
-      std::cerr << "bsim::calcEnuWgt returned " << status << " for " 
-                << dkmeta->location[iloc].name << std::endl;
+    bsim::calcEnuWgt(decay,n,x,y,z,enu,wgt,status);
+
+    for (size_t k = 0; k < n; ++k ) {
+      if ( status[k] != 0 ) {
+        std::cerr << "bsim::calcEnuWgt returned " << status[k] << " for " 
+                  << dkmeta->location[ifirst+k].name << std::endl;
+      }
+      // with the recalculated energy compute the momentum components
+      // along the unit vector from the origin of decay (as TVector3::Unit)
+      double dx = x[k] - decay.vx;
+      double dy = y[k] - decay.vy;
+      double dz = z[k] - decay.vz;
+      double mag2 = dx*dx + dy*dy + dz*dz;
+      double inv  = ( mag2 > 0 ) ? 1.0/TMath::Sqrt(mag2) : 1.0;
+      bsim::NuRay anuray(enu[k]*(dx*inv), enu[k]*(dy*inv), enu[k]*(dz*inv),
+                         enu[k], wgt[k]);
+      dk2nu->nuray.push_back(anuray);
     }
-    // with the recalculated energy compute the momentum components
-    TVector3 xyzDk(dk2nu->decay.vx,dk2nu->decay.vy,dk2nu->decay.vz);  // origin of decay
-    TVector3 p3 = enu_xy * (xyzDet - xyzDk).Unit();
-    bsim::NuRay anuray(p3.x(), p3.y(), p3.z(), enu_xy, wgt_xy);
-    dk2nu->nuray.push_back(anuray);
   }
 }
 
 //___________________________________________________________________________
-int bsim::calcEnuWgt(const bsim::Decay& decay, const TVector3& xyz,
-                     double& enu, double& wgt_xy)
+int bsim::calcEnuWgt(const bsim::Decay& decay, size_t n,
+                     const double* x, const double* y, const double* z,
+                     double* enu, double* wgt_xy, int* status)
 {
   // Neutrino Energy and Weight at arbitrary point
   // Based on:
@@ -65,6 +192,9 @@ int bsim::calcEnuWgt(const bsim::Decay& decay, const TVector3& xyz,
   //              with Enu>30 GeV
   // rwh 10/ 9/08 transliterate function from f77 to C++
 
+  // Many points are evaluated per call; everything that depends only on
+  // the decay is computed once up front, outside the loop over points.
+
   // Original function description:
   //   Real function for use with PAW Ntuple To transform from destination
   //   detector geometry to the unit sphere moving with decaying hadron with
@@ -78,81 +208,30 @@ int bsim::calcEnuWgt(const bsim::Decay& decay, const TVector3& xyz,
   //   For muon decays, correction for non-isotropic nature of decay is done.
 
   // Arguments:
-  //    dk2nu    :: contains current decay information
-  //    xyz      :: 3-vector of position to evaluate
+  //    decay    :: contains current decay information
+  //    n        :: number of positions to evaluate
+  //    x,y,z    :: arrays of positions to evaluate
   //                in *beam* frame coordinates  (cm units)
-  //    enu      :: resulting energy
-  //    wgt_xy   :: resulting weight
+  //    enu      :: array of resulting energies
+  //    wgt_xy   :: array of resulting weights
+  //    status   :: [optional] array of error codes per position
   // Return:
-  //    (int)    :: error code
+  //    (int)    :: first non-zero error code, 0 if none
   // Assumptions:
   //    Energies given in GeV
   //    Particle codes have been translated from GEANT into PDG codes
 
-  // for now ... these masses _should_ come from TDatabasePDG 
-  // but use these hard-coded values to "exactly" reproduce old code
-  //
-  const double kPIMASS = 0.13957;
-  const double kKMASS  = 0.49368;
-  const double kK0MASS = 0.49767;
-  const double kMUMASS = 0.105658389;
-  const double kOMEGAMASS = 1.67245;
-
-  const int kpdg_nue       =   12;  // extended Geant 53
-  const int kpdg_nuebar    =  -12;  // extended Geant 52
-  const int kpdg_numu      =   14;  // extended Geant 56
-  const int kpdg_numubar   =  -14;  // extended Geant 55
-
-  const int kpdg_muplus     =   -13;  // Geant  5
-  const int kpdg_muminus    =    13;  // Geant  6
-  const int kpdg_pionplus   =   211;  // Geant  8
-  const int kpdg_pionminus  =  -211;  // Geant  9
-  const int kpdg_k0long     =   130;  // Geant 10  ( K0=311, K0S=310 )
-  const int kpdg_k0short    =   310;  // Geant 16
-  const int kpdg_k0mix      =   311;  
-  const int kpdg_kaonplus   =   321;  // Geant 11
-  const int kpdg_kaonminus  =  -321;  // Geant 12
-  const int kpdg_omegaminus =  3334;  // Geant 24
-  const int kpdg_omegaplus  = -3334;  // Geant 32
-
-  const double kRDET = 100.0;   // set to flux per 100 cm radius
-
-  double xpos = xyz.X();
-  double ypos = xyz.Y();
-  double zpos = xyz.Z();
-
-  enu    = 0.0;  // don't know what the final value is
-  wgt_xy = 0.0;  // but set these in case we return early due to error
-
+  for (size_t i = 0; i < n; ++i ) {
+    enu[i]    = 0.0;  // don't know what the final value is
+    wgt_xy[i] = 0.0;  // but set these in case we return early due to error
+    if ( status ) status[i] = 0;
+  }
 
-  // in principle we should get these from the particle DB
-  // but for consistency testing use the hardcoded values
-  double parent_mass = kPIMASS;
-  switch ( decay.ptype ) {
-  case kpdg_pionplus:
-  case kpdg_pionminus:
-    parent_mass = kPIMASS;
-    break;
-  case kpdg_kaonplus:
-  case kpdg_kaonminus:
-    parent_mass = kKMASS;
-    break;
-  case kpdg_k0long:
-  case kpdg_k0short:
-  case kpdg_k0mix:
-    parent_mass = kK0MASS;
-    break;
-  case kpdg_muplus:
-  case kpdg_muminus:
-    parent_mass = kMUMASS;
-    break;
-  case kpdg_omegaminus:
-  case kpdg_omegaplus:
-    parent_mass = kOMEGAMASS;
-    break;
-  default:
+  double parent_mass = parentMass(decay.ptype);
+  if ( parent_mass < 0 ) {
     std::cerr << "bsim::calcEnuWgt unknown particle type " << decay.ptype
               << std::endl << std::flush;
+    if ( status ) for (size_t i = 0; i < n; ++i ) status[i] = 1;
     assert(0);
     return 1;
   }
@@ -170,119 +249,167 @@ int bsim::calcEnuWgt(const bsim::Decay& decay, const TVector3& xyz,
 
   // Get the neutrino energy in the parent decay CM
   double enuzr = decay.necm;
-  // Get angle from parent line of flight to chosen point in beam frame
-  double rad = TMath::Sqrt( (xpos-decay.vx)*(xpos-decay.vx) +
-                            (ypos-decay.vy)*(ypos-decay.vy) +
-                            (zpos-decay.vz)*(zpos-decay.vz) );
-
-  double emrat = 1.0;
-  double costh_pardet = -999., theta_pardet = -999.;
 
   // boost correction, but only if parent hasn't stopped
-  if ( parentp > 0. ) {
-    costh_pardet = ( decay.pdpx*(xpos-decay.vx) +
-                     decay.pdpy*(ypos-decay.vy) +
-                     decay.pdpz*(zpos-decay.vz) ) 
-                     / ( parentp * rad);
-    if ( costh_pardet >  1.0 ) costh_pardet =  1.0;
-    if ( costh_pardet < -1.0 ) costh_pardet = -1.0;
-    theta_pardet = TMath::ACos(costh_pardet);
-
-    // Weighted neutrino energy in beam, approx, good for small theta
-    emrat = 1.0 / ( gamma * ( 1.0 - beta_mag * costh_pardet ));
-  }
-
-  enu = emrat * enuzr;  // the energy ... normally
-
-  // Get solid angle/4pi for detector element
-  // small angle approximation, fixed by Alex Radovic
-  //SAA//  double sangdet = ( kRDET*kRDET / 
-  //SAA//                   ( (zpos-decay.vz)*(zpos-decay.vz) ) ) / 4.0;
-  double sanddetcomp = TMath::Sqrt( ( (xpos-decay.vx)*(xpos-decay.vx) ) +
-                                    ( (ypos-decay.vy)*(ypos-decay.vy) ) +
-                                    ( (zpos-decay.vz)*(zpos-decay.vz) )   );
-  double sangdet = (1.0-TMath::Cos(TMath::ATan( kRDET / sanddetcomp )))/2.0;
-
-  // Weight for solid angle and lorentz boost
-  wgt_xy = sangdet * ( emrat * emrat );  // ! the weight ... normally
+  const bool boost = ( parentp > 0. );
 
-  // Done for all except polarized muon decay
-  // in which case need to modify weight 
-  // (must be done in double precision)
-  if ( decay.ptype == kpdg_muplus || decay.ptype == kpdg_muminus) {
-    double beta[3], p_dcm_nu[4], p_nu[3], p_pcm_mp[3], partial;
+  // Polarized muon decay needs the weight modified (in double precision).
+  // The parts that depend only on the decay are done here, once.
+  const bool ismuon = ( decay.ptype == kpdg_muplus || 
+                        decay.ptype == kpdg_muminus );
+  double beta[3] = { 0., 0., 0. };
+  double p_pcm_mp[3] = { 0., 0., 0. };
+  double p_pcm = 0.;
+  int    wgt_mode = 0;  // 0 = nue, 1 = numu, 2 = bad neutrino type
+  double xnu = 0.;
+  if ( ismuon ) {
+    // Boost parent of mu to mu production CM
+    double particle_energy = decay.ppenergy;
+    double gammap = particle_energy/parent_mass;
+    double betap[3];
+    betap[0] = decay.ppdxdz * decay.pppz / particle_energy;
+    betap[1] = decay.ppdydz * decay.pppz / particle_energy;
+    betap[2] =                    decay.pppz / particle_energy;
+    double partial = gammap * ( betap[0]*decay.muparpx + 
+                                betap[1]*decay.muparpy + 
+                                betap[2]*decay.muparpz );
+    partial = decay.mupare - partial/(gammap+1.0);
+    p_pcm_mp[0] = decay.muparpx - betap[0]*gammap*partial;
+    p_pcm_mp[1] = decay.muparpy - betap[1]*gammap*partial;
+    p_pcm_mp[2] = decay.muparpz - betap[2]*gammap*partial;
+    p_pcm = TMath::Sqrt ( p_pcm_mp[0]*p_pcm_mp[0] +
+                          p_pcm_mp[1]*p_pcm_mp[1] +
+                          p_pcm_mp[2]*p_pcm_mp[2] );
 
-    // Boost neu neutrino to mu decay CM
+    // Boost to take the neutrino to the mu decay CM
     beta[0] = decay.pdpx / parent_energy;
     beta[1] = decay.pdpy / parent_energy;
     beta[2] = decay.pdpz / parent_energy;
-    p_nu[0] = (xpos-decay.vx)*enu/rad;
-    p_nu[1] = (ypos-decay.vy)*enu/rad;
-    p_nu[2] = (zpos-decay.vz)*enu/rad;
-    partial = gamma * 
-      (beta[0]*p_nu[0] + beta[1]*p_nu[1] + beta[2]*p_nu[2] );
-    partial = enu - partial/(gamma+1.0);
-    // the following calculation is numerically imprecise
-    // especially p_dcm_nu[2] leads to taking the difference of numbers 
-    //  of order ~10's and getting results of order ~0.02's
-    // for g3numi we're starting with floats (ie. good to ~1 part in 10^7)
-    p_dcm_nu[0] = p_nu[0] - beta[0]*gamma*partial;
-    p_dcm_nu[1] = p_nu[1] - beta[1]*gamma*partial;
-    p_dcm_nu[2] = p_nu[2] - beta[2]*gamma*partial;
-    p_dcm_nu[3] = TMath::Sqrt( p_dcm_nu[0]*p_dcm_nu[0] +
-                               p_dcm_nu[1]*p_dcm_nu[1] +
-                               p_dcm_nu[2]*p_dcm_nu[2] );
 
-    // Boost parent of mu to mu production CM
-    double particle_energy = decay.ppenergy;
-    gamma = particle_energy/parent_mass;
-    beta[0] = decay.ppdxdz * decay.pppz / particle_energy;
-    beta[1] = decay.ppdydz * decay.pppz / particle_energy;
-    beta[2] =                    decay.pppz / particle_energy;
-    partial = gamma * ( beta[0]*decay.muparpx + 
-                        beta[1]*decay.muparpy + 
-                        beta[2]*decay.muparpz );
-    partial = decay.mupare - partial/(gamma+1.0);
-    p_pcm_mp[0] = decay.muparpx - beta[0]*gamma*partial;
-    p_pcm_mp[1] = decay.muparpy - beta[1]*gamma*partial;
-    p_pcm_mp[2] = decay.muparpz - beta[2]*gamma*partial;
-    double p_pcm = TMath::Sqrt ( p_pcm_mp[0]*p_pcm_mp[0] +
-                                 p_pcm_mp[1]*p_pcm_mp[1] +
-                                 p_pcm_mp[2]*p_pcm_mp[2] );
-
-    const double eps = 1.0e-30;  // ? what value to use
-    if ( p_pcm < eps || p_dcm_nu[3] < eps ) {
-      return 3; // mu missing parent info?
-    }
-    // Calc new decay angle w.r.t. (anti)spin direction
-    double costh = ( p_dcm_nu[0]*p_pcm_mp[0] +
-                     p_dcm_nu[1]*p_pcm_mp[1] +
-                     p_dcm_nu[2]*p_pcm_mp[2] ) /
-                   ( p_dcm_nu[3]*p_pcm );
-    if ( costh >  1.0 ) costh =  1.0;
-    if ( costh < -1.0 ) costh = -1.0;
-    // Calc relative weight due to angle difference
-    double wgt_ratio = 0.0;
     switch ( decay.ntype ) {
     case kpdg_nue:
     case kpdg_nuebar:
-      wgt_ratio = 1.0 - costh;
+      wgt_mode = 0;
       break;
     case kpdg_numu:
     case kpdg_numubar:
-    {
-      double xnu = 2.0 * enuzr / kMUMASS;
-      wgt_ratio = ( (3.0-2.0*xnu )  - (1.0-2.0*xnu)*costh ) / (3.0-2.0*xnu);
+      wgt_mode = 1;
+      xnu = 2.0 * enuzr / kMUMASS;
       break;
-    }
     default:
-      return 2; // bad neutrino type
+      wgt_mode = 2;
     }
-    wgt_xy = wgt_xy * wgt_ratio;
+  }
+  const double eps = 1.0e-30;  // ? what value to use
 
-  } // ptype is muon
+  int first_status = 0;
+  for (size_t i = 0; i < n; ++i ) {
+    double dx = x[i] - decay.vx;
+    double dy = y[i] - decay.vy;
+    double dz = z[i] - decay.vz;
 
-  return 0;
+    // Get angle from parent line of flight to chosen point in beam frame
+    double rad = TMath::Sqrt( dx*dx + dy*dy + dz*dz );
+
+    double emrat = 1.0;
+    if ( boost ) {
+      double costh_pardet = ( decay.pdpx*dx + decay.pdpy*dy + decay.pdpz*dz )
+                            / ( parentp * rad);
+      if ( costh_pardet >  1.0 ) costh_pardet =  1.0;
+      if ( costh_pardet < -1.0 ) costh_pardet = -1.0;
+
+      // Weighted neutrino energy in beam, approx, good for small theta
+      emrat = 1.0 / ( gamma * ( 1.0 - beta_mag * costh_pardet ));
+    }
+
+    double e = emrat * enuzr;  // the energy ... normally
+
+    // Get solid angle/4pi for detector element
+    // small angle approximation, fixed by Alex Radovic
+    //SAA//  double sangdet = ( kRDET*kRDET / 
+    //SAA//                   ( (zpos-decay.vz)*(zpos-decay.vz) ) ) / 4.0;
+    double sangdet = (1.0-TMath::Cos(TMath::ATan( kRDET / rad )))/2.0;
+
+    // Weight for solid angle and lorentz boost
+    double w = sangdet * ( emrat * emrat );  // ! the weight ... normally
+
+    int istatus = 0;
+    if ( ismuon ) {
+      double p_dcm_nu[4], p_nu[3], partial;
+
+      p_nu[0] = dx*e/rad;
+      p_nu[1] = dy*e/rad;
+      p_nu[2] = dz*e/rad;
+      partial = gamma * 
+        (beta[0]*p_nu[0] + beta[1]*p_nu[1] + beta[2]*p_nu[2] );
+      partial = e - partial/(gamma+1.0);
+      // the following calculation is numerically imprecise
+      // especially p_dcm_nu[2] leads to taking the difference of numbers 
+      //  of order ~10's and getting results of order ~0.02's
+      // for g3numi we're starting with floats (ie. good to ~1 part in 10^7)
+      p_dcm_nu[0] = p_nu[0] - beta[0]*gamma*partial;
+      p_dcm_nu[1] = p_nu[1] - beta[1]*gamma*partial;
+      p_dcm_nu[2] = p_nu[2] - beta[2]*gamma*partial;
+      p_dcm_nu[3] = TMath::Sqrt( p_dcm_nu[0]*p_dcm_nu[0] +
+                                 p_dcm_nu[1]*p_dcm_nu[1] +
+                                 p_dcm_nu[2]*p_dcm_nu[2] );
+
+      if ( p_pcm < eps || p_dcm_nu[3] < eps ) {
+        istatus = 3; // mu missing parent info?
+      } else if ( wgt_mode == 2 ) {
+        istatus = 2; // bad neutrino type
+      } else {
+        // Calc new decay angle w.r.t. (anti)spin direction
+        double costh = ( p_dcm_nu[0]*p_pcm_mp[0] +
+                         p_dcm_nu[1]*p_pcm_mp[1] +
+                         p_dcm_nu[2]*p_pcm_mp[2] ) /
+                       ( p_dcm_nu[3]*p_pcm );
+        if ( costh >  1.0 ) costh =  1.0;
+        if ( costh < -1.0 ) costh = -1.0;
+        // Calc relative weight due to angle difference
+        double wgt_ratio;
+        if ( wgt_mode == 0 ) {
+          wgt_ratio = 1.0 - costh;
+        } else {
+          wgt_ratio = ( (3.0-2.0*xnu )  - (1.0-2.0*xnu)*costh ) / (3.0-2.0*xnu);
+        }
+        w = w * wgt_ratio;
+      }
+    } // ptype is muon
+
+    enu[i]    = e;
+    wgt_xy[i] = w;
+    if ( status ) status[i] = istatus;
+    if ( istatus != 0 && first_status == 0 ) first_status = istatus;
+  }
+
+  return first_status;
+}
+//___________________________________________________________________________
+int bsim::calcEnuWgt(size_t ndecay, const bsim::Decay* decays,
+                     const TVector3& xyz,
+                     double* enu, double* wgt_xy, int* status)
+{
+  double xpos = xyz.X();
+  double ypos = xyz.Y();
+  double zpos = xyz.Z();
+
+  int first_status = 0;
+  for (size_t i = 0; i < ndecay; ++i ) {
+    int istatus = bsim::calcEnuWgt(decays[i],1,&xpos,&ypos,&zpos,
+                                   enu+i,wgt_xy+i,status ? status+i : 0);
+    if ( istatus != 0 && first_status == 0 ) first_status = istatus;
+  }
+  return first_status;
+}
+//___________________________________________________________________________
+int bsim::calcEnuWgt(const bsim::Decay& decay, const TVector3& xyz,
+                     double& enu, double& wgt_xy)
+{
+  double xpos = xyz.X();
+  double ypos = xyz.Y();
+  double zpos = xyz.Z();
+  return bsim::calcEnuWgt(decay,1,&xpos,&ypos,&zpos,&enu,&wgt_xy);
 }
 //___________________________________________________________________________
 
@@ -292,3 +419,131 @@ int bsim::calcEnuWgt(const bsim::Dk2Nu* dk2nu, const TVector3& xyz,
   return bsim::calcEnuWgt(dk2nu->decay,xyz,enu,wgt_xy);
 }
 //___________________________________________________________________________
+double bsim::calcEnuMax(const bsim::Decay& decay)
+{
+  // evaluate at a point straight ahead of the parent, where cos(theta)=1;
+  // a stopped parent gives necm in every direction
+  double parentp = TMath::Sqrt( decay.pdpx*decay.pdpx +
+                                decay.pdpy*decay.pdpy +
+                                decay.pdpz*decay.pdpz );
+  const double dist = 1.0e5;  // cm, any distance will do
+  double x = decay.vx, y = decay.vy, z = decay.vz;
+  if ( parentp > 0. ) {
+    x += dist * decay.pdpx / parentp;
+    y += dist * decay.pdpy / parentp;
+    z += dist * decay.pdpz / parentp;
+  } else {
+    z += dist;
+  }
+
+  double enu = 0, wgt_xy = 0;
+  bsim::calcEnuWgt(decay,1,&x,&y,&z,&enu,&wgt_xy);
+  // the cosine might come out a hair below 1
+  return enu * ( 1.0 + 1.0e-9 );
+}
+//___________________________________________________________________________
+int bsim::calcEnuWgtMax(const bsim::Decay& decay, const TVector3& base,
+                        const TVector3& dir1, const TVector3& dir2,
+                        double& enumax, double& wgtmax)
+{
+  // The energy is largest where the angle to the parent's line of flight
+  // is smallest, the solid angle where the distance is smallest; bound
+  // each separately over the parallelogram and combine.  Both searches
+  // are exact: the cone of a fixed opening angle cuts the window plane
+  // in a convex region, so off the window interior the extremes lie on
+  // one of the four edges.
+
+  enumax = 0.0;
+  wgtmax = 0.0;
+
+  double parent_mass = parentMass(decay.ptype);
+  if ( parent_mass < 0 ) {
+    std::cerr << "bsim::calcEnuWgtMax unknown particle type " << decay.ptype
+              << std::endl << std::flush;
+    return 1;
+  }
+
+  const TVector3 vtx(decay.vx,decay.vy,decay.vz);
+  const TVector3 w0 = base - vtx;  // window corner relative to the decay
+  const TVector3 corner[4] = { w0, w0 + dir1, w0 + dir1 + dir2, w0 + dir2 };
+  const TVector3 edge[4]   = { dir1, dir2, -dir1, -dir2 };
+
+  // closest approach of the window to the decay point
+  double u, v;
+  windowUV(-w0,dir1,dir2,u,v);
+  double rad2min;
+  if ( u >= 0 && u <= 1 && v >= 0 && v <= 1 ) {
+    rad2min = ( w0 + u*dir1 + v*dir2 ).Mag2();
+  } else {
+    rad2min = segmentDist2(corner[0],edge[0]);
+    for (int k = 1; k < 4; ++k )
+      rad2min = TMath::Min(rad2min,segmentDist2(corner[k],edge[k]));
+  }
+  double radmin = TMath::Sqrt(rad2min);
+
+  double parentp2 = ( decay.pdpx*decay.pdpx +
+                      decay.pdpy*decay.pdpy +
+                      decay.pdpz*decay.pdpz );
+  double parent_energy = TMath::Sqrt( parentp2 +
+                                     parent_mass*parent_mass);
+  double parentp = TMath::Sqrt( parentp2 );
+
+  double gamma     = parent_energy / parent_mass;
+  double gamma_sqr = gamma * gamma;
+  double beta_mag  = TMath::Sqrt( ( gamma_sqr - 1.0 )/gamma_sqr );
+
+  // smallest angle between the parent's line of flight and the window
+  double emrat = 1.0;
+  if ( parentp > 0. ) {
+    TVector3 pdir(decay.pdpx/parentp,decay.pdpy/parentp,decay.pdpz/parentp);
+    double cosmax = -1.0;
+    if ( radmin <= 0 ) {
+      cosmax = 1.0;
+    } else {
+      TVector3 normal = dir1.Cross(dir2);
+      double along = normal.Dot(pdir);
+      if ( along != 0 ) {
+        double s = normal.Dot(w0) / along;
+        if ( s > 0 ) {
+          windowUV(s*pdir - w0,dir1,dir2,u,v);
+          if ( u >= 0 && u <= 1 && v >= 0 && v <= 1 ) cosmax = 1.0;
+        }
+      }
+      for (int k = 0; k < 4 && cosmax < 1.0; ++k )
+        cosmax = TMath::Max(cosmax,segmentCosMax(pdir,corner[k],edge[k]));
+      if ( cosmax > 1.0 ) cosmax = 1.0;
+    }
+    emrat = 1.0 / ( gamma * ( 1.0 - beta_mag * cosmax ));
+  }
+
+  double sangdet = (1.0-TMath::Cos(TMath::ATan( kRDET / radmin )))/2.0;
+
+  // polarized muon decays: the correction is linear in cos(theta) so its
+  // extremes are at cos(theta) = +/-1
+  double wgt_ratio = 1.0;
+  if ( decay.ptype == kpdg_muplus || decay.ptype == kpdg_muminus ) {
+    switch ( decay.ntype ) {
+    case kpdg_nue:
+    case kpdg_nuebar:
+      wgt_ratio = 2.0;
+      break;
+    case kpdg_numu:
+    case kpdg_numubar:
+      {
+        double xnu = 2.0 * decay.necm / kMUMASS;
+        double r1 = TMath::Abs( 2.0 / (3.0-2.0*xnu) );
+        double r2 = TMath::Abs( (4.0-4.0*xnu) / (3.0-2.0*xnu) );
+        wgt_ratio = TMath::Max(1.0,TMath::Max(r1,r2));
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  // allow for rounding differences against calcEnuWgt
+  enumax = emrat * decay.necm * ( 1.0 + 1.0e-9 );
+  wgtmax = sangdet * ( emrat * emrat ) * wgt_ratio * ( 1.0 + 1.0e-6 );
+  return 0;
+}
+//___________________________________________________________________________
@@ -1,5 +1,6 @@
 #include <iostream>
 #include <cassert>
+#include <cstddef>
 
 namespace bsim {
   class Decay;
@@ -13,7 +14,24 @@ namespace bsim {
 /// bsim namespace for beam simulation classes and functions
 namespace bsim { 
 
-  /// workhorse routine
+  /// workhorse routine: one decay evaluated at n positions given as
+  /// arrays (beam frame, cm).  The parent kinematics are computed once
+  /// for all positions.  Results are bit-for-bit those of the original
+  /// one-position-per-call routine, unless the compiler is allowed to
+  /// fuse multiply-adds (-ffp-contract=fast on FMA hardware); then they
+  /// agree only to rounding, as two such builds of the old code would.
+  /// If status is non-null it receives the code for each position; the
+  /// return value is the first non-zero code (or 0).
+  int calcEnuWgt(const bsim::Decay& decay, size_t n,
+                 const double* x, const double* y, const double* z,
+                 double* enu, double* wgt_xy, int* status = 0);
+
+  /// batch interface: a block of ndecay decays evaluated at one position
+  int calcEnuWgt(size_t ndecay, const bsim::Decay* decays,
+                 const TVector3& xyz,
+                 double* enu, double* wgt_xy, int* status = 0);
+
+  /// single decay, single position
   int calcEnuWgt(const bsim::Decay& decay, const TVector3& xyz,
                  double& enu, double& wgt_xy);
 
@@ -21,6 +39,16 @@ namespace bsim {
   int calcEnuWgt(const bsim::Dk2Nu* dk2nu, const TVector3& xyz,
                  double& enu, double& wgt_xy);
 
+  /// upper bound on the energy the neutrino from this decay can have at
+  /// any position (it is largest along the parent's line of flight)
+  double calcEnuMax(const bsim::Decay& decay);
+
+  /// upper bounds on the energy and weight calcEnuWgt gives for points in
+  /// the parallelogram base + u*dir1 + v*dir2 (0 <= u,v <= 1, beam frame)
+  int calcEnuWgtMax(const bsim::Decay& decay, const TVector3& base,
+                    const TVector3& dir1, const TVector3& dir2,
+                    double& enumax, double& wgtmax);
+
   /// user interface
   void calcLocationWeights(const bsim::DkMeta* dkmeta, bsim::Dk2Nu* dk2nu);
 
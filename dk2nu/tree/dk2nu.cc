@@ -206,6 +206,9 @@ void bsim::Dk2Nu::clear(const std::string &)
   nuray.clear();     /// clear the vector
   decay.clear();     /// clear the object
   ancestor.clear();  /// clear the vector
+  ancchain = -1;
+  ancleaf  = -1;
+  anclen   = 0;
 
   ppvx  = bsim::kDfltDouble;
   ppvy  = bsim::kDfltDouble;
@@ -238,6 +241,9 @@ std::string bsim::Dk2Nu::AsString(const std::string& opt) const
   size_t nanc = ancestor.size();
   bool printanc = true; // ( opt.find("a") != std::string::npos);
   s << nanc << " ancestors " << (printanc?"":"(suppressed)") << "\n";
+  if ( ancchain >= 0 && nanc == 0 )
+    s << "  (" << anclen << " shared: dkancTree entry " << ancchain
+      << " node " << ancleaf << ")\n";
   if ( ! printanc ) nanc = 0;
   for ( size_t ianc = 0; ianc < nanc; ++ianc ) {
     s << "[" << std::setw(2) << ianc << "] " << ancestor[ianc] << "\n";
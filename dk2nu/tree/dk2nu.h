@@ -30,7 +30,7 @@
 #include <vector>
 #include <string>
 
-#define DK2NUVER 8   // KEEP THIS UP-TO-DATE!  increment for each change
+#define DK2NUVER 9   // KEEP THIS UP-TO-DATE!  increment for each change
 
 namespace bsim {
   /**
@@ -298,6 +298,16 @@ namespace bsim {
    std::vector<bsim::NuRay> nuray;   ///< rays through detector fixed points
    std::vector<bsim::Ancestor> ancestor;  ///< chain from proton to neutrino
 
+   /**
+    * Optional shared ancestor chains (see AncChains.h): if ancchain >= 0
+    * the ancestor vector was left empty on file and the chain is the
+    * anclen nodes ending at node ancleaf of entry ancchain of the file's
+    * "dkancTree"; bsim::AncChainReader::Restore() fills it back in
+    */
+   Long64_t ancchain;               ///< dkancTree entry (this file), -1 if none
+   Int_t    ancleaf;                ///< node of the neutrino in that entry
+   Int_t    anclen;                 ///< number of ancestors in the chain
+
    /**
     * These are ancestor.vx[size-2]  kept, for now, for convenience
     */